@@ -86,7 +86,7 @@ static void reset_channel (struct channel *);
 static bool check_device_type (struct disk *);
 static void identify_ata_device (struct disk *);
 
-static void select_sector (struct disk *, disk_sector_t);
+static void select_sectors (struct disk *, disk_sector_t, size_t cnt);
 static void issue_pio_command (struct channel *, uint8_t command);
 static void input_sector (struct channel *, void *);
 static void output_sector (struct channel *, const void *);
@@ -218,46 +218,89 @@ disk_size (struct disk *d)
    per-disk locking is unneeded. */
 void
 disk_read (struct disk *d, disk_sector_t sec_no, void *buffer) 
+{
+  disk_readv (d, sec_no, &buffer, 1);
+}
+
+/* Write sector SEC_NO to disk D from BUFFER, which must contain
+   DISK_SECTOR_SIZE bytes.  Returns after the disk has
+   acknowledged receiving the data.
+   Internally synchronizes accesses to disks, so external
+   per-disk locking is unneeded. */
+void
+disk_write (struct disk *d, disk_sector_t sec_no, const void *buffer)
+{
+  disk_writev (d, sec_no, &buffer, 1);
+}
+
+/* Reads the CNT consecutive sectors starting at SEC_NO from disk
+   D with a single command, which is much faster than reading
+   them one at a time.  Sector SEC_NO + I is read into
+   BUFFERS[I], which must have room for DISK_SECTOR_SIZE bytes.
+   CNT must be between 1 and DISK_MULTIPLE_MAX.
+   Internally synchronizes accesses to disks, so external
+   per-disk locking is unneeded. */
+void
+disk_readv (struct disk *d, disk_sector_t sec_no, void *const buffers[],
+            size_t cnt) 
 {
   struct channel *c;
+  size_t i;
   
   ASSERT (d != NULL);
-  ASSERT (buffer != NULL);
+  ASSERT (buffers != NULL);
+  ASSERT (cnt > 0 && cnt <= DISK_MULTIPLE_MAX);
 
   c = d->channel;
   lock_acquire (&c->lock);
-  select_sector (d, sec_no);
+  select_sectors (d, sec_no, cnt);
   issue_pio_command (c, CMD_READ_SECTOR_RETRY);
-  sema_down (&c->completion_wait);
-  if (!wait_while_busy (d))
-    PANIC ("%s: disk read failed, sector=%"PRDSNu, d->name, sec_no);
-  input_sector (c, buffer);
-  d->read_cnt++;
+  for (i = 0; i < cnt; i++) 
+    {
+      /* The disk interrupts when each sector is ready. */
+      ASSERT (buffers[i] != NULL);
+      sema_down (&c->completion_wait);
+      if (!wait_while_busy (d))
+        PANIC ("%s: disk read failed, sector=%"PRDSNu, d->name, sec_no + i);
+      input_sector (c, buffers[i]);
+    }
+  d->read_cnt += cnt;
   lock_release (&c->lock);
 }
 
-/* Write sector SEC_NO to disk D from BUFFER, which must contain
-   DISK_SECTOR_SIZE bytes.  Returns after the disk has
-   acknowledged receiving the data.
+/* Writes the CNT consecutive sectors starting at SEC_NO on disk
+   D with a single command, which is much faster than writing
+   them one at a time.  Sector SEC_NO + I is written from
+   BUFFERS[I], which must contain DISK_SECTOR_SIZE bytes.  CNT
+   must be between 1 and DISK_MULTIPLE_MAX.  Returns after the
+   disk has acknowledged receiving all of the data.
    Internally synchronizes accesses to disks, so external
    per-disk locking is unneeded. */
 void
-disk_write (struct disk *d, disk_sector_t sec_no, const void *buffer)
+disk_writev (struct disk *d, disk_sector_t sec_no,
+             const void *const buffers[], size_t cnt)
 {
   struct channel *c;
+  size_t i;
   
   ASSERT (d != NULL);
-  ASSERT (buffer != NULL);
+  ASSERT (buffers != NULL);
+  ASSERT (cnt > 0 && cnt <= DISK_MULTIPLE_MAX);
 
   c = d->channel;
   lock_acquire (&c->lock);
-  select_sector (d, sec_no);
+  select_sectors (d, sec_no, cnt);
   issue_pio_command (c, CMD_WRITE_SECTOR_RETRY);
-  if (!wait_while_busy (d))
-    PANIC ("%s: disk write failed, sector=%"PRDSNu, d->name, sec_no);
-  output_sector (c, buffer);
-  sema_down (&c->completion_wait);
-  d->write_cnt++;
+  for (i = 0; i < cnt; i++) 
+    {
+      /* The disk interrupts when it has taken each sector. */
+      ASSERT (buffers[i] != NULL);
+      if (!wait_while_busy (d))
+        PANIC ("%s: disk write failed, sector=%"PRDSNu, d->name, sec_no + i);
+      output_sector (c, buffers[i]);
+      sema_down (&c->completion_wait);
+    }
+  d->write_cnt += cnt;
   lock_release (&c->lock);
 }
 
@@ -426,18 +469,21 @@ print_ata_string (char *string, size_t size)
 }
 
 /* Selects device D, waiting for it to become ready, and then
-   writes SEC_NO to the disk's sector selection registers.  (We
+   writes SEC_NO and CNT to the disk's sector selection
+   registers, to transfer CNT sectors starting at SEC_NO.  (We
    use LBA mode.) */
 static void
-select_sector (struct disk *d, disk_sector_t sec_no) 
+select_sectors (struct disk *d, disk_sector_t sec_no, size_t cnt) 
 {
   struct channel *c = d->channel;
 
+  ASSERT (cnt > 0 && cnt <= DISK_MULTIPLE_MAX);
   ASSERT (sec_no < d->capacity);
-  ASSERT (sec_no < (1UL << 28));
+  ASSERT (cnt <= d->capacity - sec_no);
+  ASSERT (sec_no + cnt <= (1UL << 28));
   
   select_device_wait (d);
-  outb (reg_nsect (c), 1);
+  outb (reg_nsect (c), cnt);     /* 0 means 256. */
   outb (reg_lbal (c), sec_no);
   outb (reg_lbam (c), sec_no >> 8);
   outb (reg_lbah (c), (sec_no >> 16));
@@ -1,5 +1,6 @@
 #include "devices/timer.h"
 #include <debug.h>
+#include <heap.h>
 #include <inttypes.h>
 #include <round.h>
 #include <stdio.h>
@@ -20,11 +21,56 @@
 /* Number of timer ticks since OS booted. */
 static int64_t ticks;
 
+/* Threads blocked in timer_sleep(), ordered by wakeup tick so
+   that the timer interrupt only has to look at the earliest
+   one. */
+static struct heap sleepers;
+
+/* Timing wheel.
+
+   Armed timeouts live in a hierarchical timing wheel with
+   WHEEL_LEVELS levels of WHEEL_SLOTS slots each.  Each slot in
+   level 0 holds the timeouts due at a single tick; each slot in
+   level L covers WHEEL_SLOTS**L ticks.  A timeout due less than
+   WHEEL_SLOTS**(L+1) ticks from now goes into level L, in the
+   slot selected by the corresponding bits of its deadline.
+
+   Every time the level 0 index wraps around to 0, the current
+   slot of level 1 is "cascaded", that is, its timeouts are
+   redistributed into level 0, and likewise up the hierarchy.
+   Arming, canceling and running a timeout therefore all take
+   constant time, amortized over the cascades, no matter how
+   many timeouts are armed.  Timeouts further away than the
+   wheel spans wait in the last level and are cascaded again
+   until they come within range. */
+#define WHEEL_BITS 6                    /* Index bits per level. */
+#define WHEEL_SLOTS (1 << WHEEL_BITS)   /* Slots per level. */
+#define WHEEL_MASK (WHEEL_SLOTS - 1)    /* Mask for a slot index. */
+#define WHEEL_LEVELS 4                  /* Number of levels. */
+#define WHEEL_SPAN ((int64_t) 1 << (WHEEL_BITS * WHEEL_LEVELS))
+
+static struct list wheel[WHEEL_LEVELS][WHEEL_SLOTS];
+static int64_t wheel_base;              /* Next tick to process. */
+
+/* Timeout statistics. */
+static long long timeout_add_cnt;       /* # of timeouts armed. */
+static long long timeout_run_cnt;       /* # of timeouts run. */
+static long long timeout_cancel_cnt;    /* # of timeouts canceled. */
+
+/* Timer interrupt cost, in CPU cycles. */
+static int64_t intr_cnt;                /* # of timer interrupts. */
+static uint64_t intr_cycles;            /* Total cycles spent. */
+static uint64_t intr_max_cycles;        /* Most cycles in one. */
+
 /* Number of loops per timer tick.
    Initialized by timer_calibrate(). */
 static unsigned loops_per_tick;
 
 static intr_handler_func timer_interrupt;
+static heap_less_func wakeup_less;
+static void wheel_insert (struct timeout *);
+static int wheel_cascade (int level);
+static void wheel_advance (void);
 static bool too_many_loops (unsigned loops);
 static void busy_wait (int64_t loops);
 static void real_time_sleep (int64_t num, int32_t denom);
@@ -38,11 +84,16 @@ timer_init (void)
   /* 8254 input frequency divided by TIMER_FREQ, rounded to
      nearest. */
   uint16_t count = (1193180 + TIMER_FREQ / 2) / TIMER_FREQ;
+  int level, slot;
 
   outb (0x43, 0x34);    /* CW: counter 0, LSB then MSB, mode 2, binary. */
   outb (0x40, count & 0xff);
   outb (0x40, count >> 8);
 
+  heap_init (&sleepers, wakeup_less, NULL);
+  for (level = 0; level < WHEEL_LEVELS; level++)
+    for (slot = 0; slot < WHEEL_SLOTS; slot++)
+      list_init (&wheel[level][slot]);
   intr_register_ext (0x20, timer_interrupt, "8254 Timer");
 }
 
@@ -92,15 +143,24 @@ timer_elapsed (int64_t then)
   return timer_ticks () - then;
 }
 
-/* Suspends execution for approximately TICKS timer ticks. */
+/* Suspends execution for approximately TICKS timer ticks.
+   The thread blocks until the timer interrupt wakes it, so it
+   consumes no CPU time while asleep. */
 void
 timer_sleep (int64_t ticks) 
 {
-  int64_t start = timer_ticks ();
+  struct thread *t = thread_current ();
+  enum intr_level old_level;
 
   ASSERT (intr_get_level () == INTR_ON);
-  while (timer_elapsed (start) < ticks) 
-    thread_yield ();
+  if (ticks <= 0)
+    return;
+
+  old_level = intr_disable ();
+  t->wakeup_tick = timer_ticks () + ticks;
+  heap_insert (&sleepers, &t->heap_elem);
+  thread_block ();
+  intr_set_level (old_level);
 }
 
 /* Suspends execution for approximately MS milliseconds. */
@@ -124,19 +184,237 @@ timer_nsleep (int64_t ns)
   real_time_sleep (ns, 1000 * 1000 * 1000);
 }
 
+/* Arms timeout TO to call FUNC, passing AUX, from the timer
+   interrupt at tick DEADLINE.  A deadline that has already
+   passed runs at the next tick.  If TO is already armed, it is
+   rearmed with the new deadline.
+
+   This function may be called from an interrupt handler,
+   including from a timeout function. */
+void
+timer_add (struct timeout *to, int64_t deadline, timeout_func *func,
+           void *aux) 
+{
+  enum intr_level old_level;
+
+  ASSERT (to != NULL);
+  ASSERT (func != NULL);
+
+  old_level = intr_disable ();
+  if (to->pending)
+    list_remove (&to->elem);
+  to->deadline = deadline;
+  to->func = func;
+  to->aux = aux;
+  to->pending = true;
+  wheel_insert (to);
+  timeout_add_cnt++;
+  intr_set_level (old_level);
+}
+
+/* Disarms timeout TO.  Returns true if TO was armed, false if
+   it had already run or been canceled.
+
+   This function may be called from an interrupt handler,
+   including from a timeout function. */
+bool
+timer_cancel (struct timeout *to) 
+{
+  enum intr_level old_level;
+  bool was_pending;
+
+  ASSERT (to != NULL);
+
+  old_level = intr_disable ();
+  was_pending = to->pending;
+  if (was_pending)
+    {
+      list_remove (&to->elem);
+      to->pending = false;
+      timeout_cancel_cnt++;
+    }
+  intr_set_level (old_level);
+
+  return was_pending;
+}
+
+/* Returns the CPU's time-stamp counter, which counts clock
+   cycles, for timing intervals much shorter than a tick.  See
+   [IA32-v2b] "RDTSC". */
+uint64_t
+timer_cycles (void) 
+{
+  uint32_t lo, hi;
+
+  asm volatile ("rdtsc" : "=a" (lo), "=d" (hi));
+  return ((uint64_t) hi << 32) | lo;
+}
+
+/* Stores the number of timer interrupts handled since the last
+   call to timer_intr_stats_reset() into *CNT, and the average
+   and maximum number of CPU cycles spent handling each one into
+   *AVG_CYCLES and *MAX_CYCLES. */
+void
+timer_intr_stats (int64_t *cnt, uint64_t *avg_cycles, uint64_t *max_cycles) 
+{
+  enum intr_level old_level = intr_disable ();
+  *cnt = intr_cnt;
+  *avg_cycles = intr_cnt > 0 ? intr_cycles / intr_cnt : 0;
+  *max_cycles = intr_max_cycles;
+  intr_set_level (old_level);
+}
+
+/* Restarts timer interrupt cost accounting. */
+void
+timer_intr_stats_reset (void) 
+{
+  enum intr_level old_level = intr_disable ();
+  intr_cnt = 0;
+  intr_cycles = intr_max_cycles = 0;
+  intr_set_level (old_level);
+}
+
 /* Prints timer statistics. */
 void
 timer_print_stats (void) 
 {
   printf ("Timer: %"PRId64" ticks\n", timer_ticks ());
+  printf ("Timeouts: %lld armed, %lld run, %lld canceled\n",
+          timeout_add_cnt, timeout_run_cnt, timeout_cancel_cnt);
 }
 
-/* Timer interrupt handler. */
+/* Timer interrupt handler.  Wakes every sleeping thread whose
+   wakeup tick has arrived; when none has, this costs a single
+   comparison against the earliest sleeper.  Then runs the
+   timeouts that are due. */
 static void
 timer_interrupt (struct intr_frame *args UNUSED)
 {
+  uint64_t start = timer_cycles ();
+  uint64_t cycles;
+
   ticks++;
   thread_tick ();
+
+  while (!heap_empty (&sleepers))
+    {
+      struct thread *t = heap_entry (heap_min (&sleepers),
+                                     struct thread, heap_elem);
+      if (t->wakeup_tick > ticks)
+        break;
+
+      heap_pop_min (&sleepers);
+      thread_unblock (t);
+      if (thread_preempts (t))
+        intr_yield_on_return ();
+    }
+
+  wheel_advance ();
+
+  cycles = timer_cycles () - start;
+  intr_cnt++;
+  intr_cycles += cycles;
+  if (cycles > intr_max_cycles)
+    intr_max_cycles = cycles;
+}
+
+/* Orders sleeping threads by wakeup tick. */
+static bool
+wakeup_less (const struct heap_elem *a_, const struct heap_elem *b_,
+             void *aux UNUSED) 
+{
+  const struct thread *a = heap_entry (a_, struct thread, heap_elem);
+  const struct thread *b = heap_entry (b_, struct thread, heap_elem);
+
+  return a->wakeup_tick < b->wakeup_tick;
+}
+
+/* Puts armed timeout TO into the timing wheel slot for its
+   deadline.  Interrupts must be off. */
+static void
+wheel_insert (struct timeout *to) 
+{
+  int64_t deadline = to->deadline;
+  int64_t delta = deadline - wheel_base;
+  int level;
+
+  ASSERT (intr_get_level () == INTR_OFF);
+
+  if (delta < 0)
+    {
+      /* Overdue: run at the next tick processed. */
+      deadline = wheel_base;
+      delta = 0;
+    }
+  else if (delta >= WHEEL_SPAN)
+    {
+      /* Too far away: park in the last level for now. */
+      delta = WHEEL_SPAN - 1;
+      deadline = wheel_base + delta;
+    }
+
+  for (level = 0; level < WHEEL_LEVELS - 1; level++)
+    if (delta < (int64_t) 1 << (WHEEL_BITS * (level + 1)))
+      break;
+
+  list_push_back (&wheel[level][(deadline >> (WHEEL_BITS * level))
+                               & WHEEL_MASK],
+                  &to->elem);
+}
+
+/* Redistributes the timeouts in the current slot of LEVEL, which
+   must be at least 1, into the lower levels.  Returns the index
+   of the slot. */
+static int
+wheel_cascade (int level) 
+{
+  int idx = (wheel_base >> (WHEEL_BITS * level)) & WHEEL_MASK;
+  struct list *slot = &wheel[level][idx];
+
+  while (!list_empty (slot))
+    wheel_insert (list_entry (list_pop_front (slot), struct timeout, elem));
+  return idx;
+}
+
+/* Runs every timeout that is due at or before the current tick.
+   Called from the timer interrupt. */
+static void
+wheel_advance (void) 
+{
+  while (wheel_base <= ticks)
+    {
+      int idx = wheel_base & WHEEL_MASK;
+      struct list due;
+      int level;
+
+      /* Pull timeouts down from the upper levels whenever the
+         level below wraps around. */
+      if (idx == 0)
+        for (level = 1; level < WHEEL_LEVELS; level++)
+          if (wheel_cascade (level) != 0)
+            break;
+
+      /* Run the timeouts in this slot.  We move them to a
+         private list first, so that a timeout function may
+         freely arm or cancel timeouts, including itself.  We
+         also advance wheel_base first, so that a timeout armed
+         by a timeout function for this tick or earlier goes into
+         the slot for the next tick, not into the one we just
+         emptied, which would not come around again for
+         WHEEL_SLOTS ticks. */
+      list_init (&due);
+      list_splice (list_end (&due),
+                   list_begin (&wheel[0][idx]), list_end (&wheel[0][idx]));
+      wheel_base++;
+      while (!list_empty (&due))
+        {
+          struct timeout *to = list_entry (list_pop_front (&due),
+                                           struct timeout, elem);
+          to->pending = false;
+          timeout_run_cnt++;
+          to->func (to->aux);
+        }
+    }
 }
 
 /* Returns true if LOOPS iterations waits for more than one timer
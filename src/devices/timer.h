@@ -1,7 +1,9 @@
 #ifndef DEVICES_TIMER_H
 #define DEVICES_TIMER_H
 
+#include <list.h>
 #include <round.h>
+#include <stdbool.h>
 #include <stdint.h>
 
 /* Number of timer interrupts per second. */
@@ -18,6 +20,31 @@ void timer_msleep (int64_t milliseconds);
 void timer_usleep (int64_t microseconds);
 void timer_nsleep (int64_t nanoseconds);
 
+/* A function run by the timer interrupt when a timeout expires.
+   It runs in an external interrupt context, so it must not
+   sleep. */
+typedef void timeout_func (void *aux);
+
+/* A callback armed with timer_add().  The caller owns the
+   storage, which must remain valid until the callback has run
+   or has been canceled with timer_cancel(). */
+struct timeout
+  {
+    struct list_elem elem;      /* Element in a timing wheel slot. */
+    int64_t deadline;           /* Tick at which to run FUNC. */
+    timeout_func *func;         /* Function to call. */
+    void *aux;                  /* Auxiliary data for FUNC. */
+    bool pending;               /* Armed but not yet run or canceled? */
+  };
+
+void timer_add (struct timeout *, int64_t deadline, timeout_func *, void *);
+bool timer_cancel (struct timeout *);
+
+uint64_t timer_cycles (void);
+void timer_intr_stats (int64_t *cnt, uint64_t *avg_cycles,
+                       uint64_t *max_cycles);
+void timer_intr_stats_reset (void);
+
 void timer_print_stats (void);
 
 #endif /* devices/timer.h */
@@ -0,0 +1,182 @@
+/* Priority queue.
+
+   See heap.h for basic information.
+
+   A pairing heap keeps each element's children in a doubly
+   linked sibling list.  The `prev' member of the leftmost child
+   points to the parent instead of to a sibling, which is how
+   heap_remove() unlinks an element in constant time before
+   melding its children back into the heap. */
+
+#include "heap.h"
+#include "../debug.h"
+
+static struct heap_elem *meld (struct heap *,
+                               struct heap_elem *, struct heap_elem *);
+static struct heap_elem *merge_pairs (struct heap *, struct heap_elem *);
+
+/* Initializes H as an empty heap that orders its elements with
+   LESS, given auxiliary data AUX. */
+void
+heap_init (struct heap *h, heap_less_func *less, void *aux)
+{
+  ASSERT (h != NULL);
+  ASSERT (less != NULL);
+
+  h->root = NULL;
+  h->elem_cnt = 0;
+  h->less = less;
+  h->aux = aux;
+}
+
+/* Inserts E into heap H.  Takes constant time. */
+void
+heap_insert (struct heap *h, struct heap_elem *e)
+{
+  ASSERT (h != NULL);
+  ASSERT (e != NULL);
+
+  e->child = e->next = e->prev = NULL;
+  h->root = meld (h, h->root, e);
+  h->elem_cnt++;
+}
+
+/* Returns the least element in H, which must not be empty.
+   Takes constant time. */
+struct heap_elem *
+heap_min (const struct heap *h)
+{
+  ASSERT (h != NULL);
+  ASSERT (h->root != NULL);
+
+  return h->root;
+}
+
+/* Removes and returns the least element in H, which must not be
+   empty. */
+struct heap_elem *
+heap_pop_min (struct heap *h)
+{
+  struct heap_elem *min;
+
+  ASSERT (h != NULL);
+  ASSERT (h->root != NULL);
+
+  min = h->root;
+  h->root = merge_pairs (h, min->child);
+  h->elem_cnt--;
+  return min;
+}
+
+/* Removes E, which must be an element of H, from H. */
+void
+heap_remove (struct heap *h, struct heap_elem *e)
+{
+  ASSERT (h != NULL);
+  ASSERT (e != NULL);
+
+  if (e == h->root)
+    {
+      heap_pop_min (h);
+      return;
+    }
+
+  /* Unlink E from its parent's list of children. */
+  ASSERT (e->prev != NULL);
+  if (e->prev->child == e)
+    e->prev->child = e->next;
+  else
+    e->prev->next = e->next;
+  if (e->next != NULL)
+    e->next->prev = e->prev;
+
+  /* Its children become a heap of their own, which we meld back
+     into H. */
+  h->root = meld (h, h->root, merge_pairs (h, e->child));
+  h->elem_cnt--;
+}
+
+/* Returns the number of elements in H. */
+size_t
+heap_size (const struct heap *h)
+{
+  return h->elem_cnt;
+}
+
+/* Returns true if H contains no elements, false otherwise. */
+bool
+heap_empty (const struct heap *h)
+{
+  return h->root == NULL;
+}
+
+/* Melds the heaps rooted at A and B, either of which may be
+   null, and returns the root of the result.  The root's sibling
+   pointers are cleared. */
+static struct heap_elem *
+meld (struct heap *h, struct heap_elem *a, struct heap_elem *b)
+{
+  if (a == NULL)
+    return b;
+  if (b == NULL)
+    return a;
+
+  if (h->less (b, a, h->aux))
+    {
+      struct heap_elem *t = a;
+      a = b;
+      b = t;
+    }
+
+  /* Make B the leftmost child of A. */
+  b->prev = a;
+  b->next = a->child;
+  if (a->child != NULL)
+    a->child->prev = b;
+  a->child = b;
+
+  a->next = a->prev = NULL;
+  return a;
+}
+
+/* Combines the sibling list that starts at FIRST into a single
+   heap and returns its root.  Uses the standard two-pass scheme:
+   meld adjacent pairs from left to right, then meld the results
+   from right to left.  Iterative, so that deep heaps cannot
+   overflow a thread's small kernel stack. */
+static struct heap_elem *
+merge_pairs (struct heap *h, struct heap_elem *first)
+{
+  struct heap_elem *pairs = NULL;
+  struct heap_elem *root = NULL;
+
+  /* First pass: meld pairs, stacking the results through their
+     `next' members. */
+  while (first != NULL)
+    {
+      struct heap_elem *a = first;
+      struct heap_elem *b = a->next;
+      struct heap_elem *rest = b != NULL ? b->next : NULL;
+
+      a->next = a->prev = NULL;
+      if (b != NULL)
+        {
+          b->next = b->prev = NULL;
+          a = meld (h, a, b);
+        }
+      a->next = pairs;
+      pairs = a;
+      first = rest;
+    }
+
+  /* Second pass: meld the stacked pairs, last pair first. */
+  while (pairs != NULL)
+    {
+      struct heap_elem *a = pairs;
+      pairs = a->next;
+      a->next = NULL;
+      root = meld (h, root, a);
+    }
+
+  return root;
+}
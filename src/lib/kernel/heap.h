@@ -0,0 +1,83 @@
+#ifndef __LIB_KERNEL_HEAP_H
+#define __LIB_KERNEL_HEAP_H
+
+/* Priority queue.
+
+   This is a pairing heap: a multiway tree in which every
+   element is no greater than any of its children, according to
+   a caller-supplied "less than" function.  Insertion and
+   melding take constant time, and removing the minimum element
+   or an arbitrary element takes O(log n) amortized time.
+
+   Like the linked list and hash table, the heap does not use
+   dynamic allocation.  Each structure that can potentially be
+   in a heap must embed a struct heap_elem member.  All of the
+   heap functions operate on these `struct heap_elem's.  The
+   heap_entry macro allows conversion from a struct heap_elem
+   back to a structure object that contains it.  Refer to
+   lib/kernel/list.h for a detailed explanation of the
+   technique.
+
+   The heap is not stable: elements that compare equal come out
+   in no particular order.  Callers that need FIFO order among
+   equals should break ties in their comparison function, e.g.
+   with a sequence number.
+
+   Changing the key of an element that is in a heap corrupts the
+   heap.  Remove the element with heap_remove(), change its key,
+   and then reinsert it. */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* Heap element. */
+struct heap_elem
+  {
+    struct heap_elem *child;    /* Leftmost child. */
+    struct heap_elem *next;     /* Next sibling. */
+    struct heap_elem *prev;     /* Previous sibling, or parent. */
+  };
+
+/* Converts pointer to heap element HEAP_ELEM into a pointer to
+   the structure that HEAP_ELEM is embedded inside.  Supply the
+   name of the outer structure STRUCT and the member name MEMBER
+   of the heap element.  See the big comment at the top of
+   lib/kernel/list.h for an example. */
+#define heap_entry(HEAP_ELEM, STRUCT, MEMBER)           \
+        ((STRUCT *) ((uint8_t *) &(HEAP_ELEM)->child    \
+                     - offsetof (STRUCT, MEMBER.child)))
+
+/* Compares the value of two heap elements A and B, given
+   auxiliary data AUX.  Returns true if A is less than B, or
+   false if A is greater than or equal to B.  The heap keeps the
+   least element at its top. */
+typedef bool heap_less_func (const struct heap_elem *a,
+                             const struct heap_elem *b,
+                             void *aux);
+
+/* Heap. */
+struct heap
+  {
+    struct heap_elem *root;     /* Least element, or null. */
+    size_t elem_cnt;            /* Number of elements in heap. */
+    heap_less_func *less;       /* Comparison function. */
+    void *aux;                  /* Auxiliary data for `less'. */
+  };
+
+/* Basic life cycle. */
+void heap_init (struct heap *, heap_less_func *, void *aux);
+
+/* Insertion and removal. */
+void heap_insert (struct heap *, struct heap_elem *);
+struct heap_elem *heap_pop_min (struct heap *);
+void heap_remove (struct heap *, struct heap_elem *);
+
+/* Heap elements. */
+struct heap_elem *heap_min (const struct heap *);
+
+/* Information. */
+size_t heap_size (const struct heap *);
+bool heap_empty (const struct heap *);
+
+#endif /* lib/kernel/heap.h */
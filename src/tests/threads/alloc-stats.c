@@ -0,0 +1,116 @@
+/* Checks that the page allocator and malloc() statistics track
+   allocations and frees. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/malloc.h"
+#include "threads/palloc.h"
+
+#define PAGE_CNT 5              /* Pages to allocate. */
+#define BLOCK_CNT 10            /* Blocks to allocate. */
+#define BLOCK_SIZE 100          /* Bytes per block, rounded to 128. */
+#define BIG_SIZE 5000           /* Bytes in big block, taking 2 pages. */
+
+static struct malloc_class_stats *find_class (struct malloc_stats *,
+                                              size_t block_size);
+
+void
+test_alloc_stats (void) 
+{
+  static struct malloc_stats before_m, after_m;
+  struct malloc_class_stats *before_c, *after_c;
+  struct palloc_stats before_p, after_p;
+  void *blocks[BLOCK_CNT];
+  void *pages, *big;
+  int i;
+
+  /* Pages. */
+  palloc_get_stats (0, &before_p);
+  pages = palloc_get_multiple (0, PAGE_CNT);
+  if (pages == NULL)
+    fail ("palloc_get_multiple failed");
+  palloc_get_stats (0, &after_p);
+  if (after_p.free_cnt != before_p.free_cnt - PAGE_CNT)
+    fail ("free pages went from %zu to %zu",
+          before_p.free_cnt, after_p.free_cnt);
+  if (after_p.alloc_cnt != before_p.alloc_cnt + 1)
+    fail ("allocations went from %llu to %llu",
+          before_p.alloc_cnt, after_p.alloc_cnt);
+  if (after_p.used_cnt != before_p.used_cnt + PAGE_CNT)
+    fail ("kernel pages in use went from %zu to %zu",
+          before_p.used_cnt, after_p.used_cnt);
+  if (after_p.peak_used < after_p.used_cnt)
+    fail ("peak of %zu pages used is too low", after_p.peak_used);
+  if (after_p.largest_free == 0 || after_p.largest_free > after_p.free_cnt)
+    fail ("largest free block of %zu pages is impossible",
+          after_p.largest_free);
+  palloc_free_multiple (pages, PAGE_CNT);
+  palloc_get_stats (0, &after_p);
+  if (after_p.free_cnt != before_p.free_cnt)
+    fail ("free pages went from %zu to %zu after freeing",
+          before_p.free_cnt, after_p.free_cnt);
+  msg ("Page allocator statistics OK.");
+
+  /* Small blocks. */
+  malloc_get_stats (&before_m);
+  for (i = 0; i < BLOCK_CNT; i++) 
+    {
+      blocks[i] = malloc (BLOCK_SIZE);
+      if (blocks[i] == NULL)
+        fail ("malloc failed");
+    }
+  malloc_get_stats (&after_m);
+  before_c = find_class (&before_m, 128);
+  after_c = find_class (&after_m, 128);
+  if (after_c->live_cnt != before_c->live_cnt + BLOCK_CNT)
+    fail ("live blocks went from %zu to %zu",
+          before_c->live_cnt, after_c->live_cnt);
+  if (after_c->alloc_cnt != before_c->alloc_cnt + BLOCK_CNT)
+    fail ("allocations went from %llu to %llu",
+          before_c->alloc_cnt, after_c->alloc_cnt);
+  if (after_c->wasted_bytes
+      != before_c->wasted_bytes + BLOCK_CNT * (128 - BLOCK_SIZE))
+    fail ("bytes lost to rounding went from %llu to %llu",
+          before_c->wasted_bytes, after_c->wasted_bytes);
+  if (after_c->arena_cnt == 0)
+    fail ("no arenas for live blocks");
+  for (i = 0; i < BLOCK_CNT; i++)
+    free (blocks[i]);
+  malloc_get_stats (&after_m);
+  if (after_c->live_cnt != before_c->live_cnt)
+    fail ("live blocks went from %zu to %zu after freeing",
+          before_c->live_cnt, after_c->live_cnt);
+  msg ("Small block statistics OK.");
+
+  /* Big blocks. */
+  big = malloc (BIG_SIZE);
+  if (big == NULL)
+    fail ("malloc failed");
+  malloc_get_stats (&after_m);
+  if (after_m.big_live_cnt != before_m.big_live_cnt + 1
+      || after_m.big_page_cnt != before_m.big_page_cnt + 2)
+    fail ("big blocks went from %zu in %zu pages to %zu in %zu pages",
+          before_m.big_live_cnt, before_m.big_page_cnt,
+          after_m.big_live_cnt, after_m.big_page_cnt);
+  free (big);
+  malloc_get_stats (&after_m);
+  if (after_m.big_live_cnt != before_m.big_live_cnt
+      || after_m.big_page_cnt != before_m.big_page_cnt)
+    fail ("big blocks not counted as freed");
+  msg ("Big block statistics OK.");
+}
+
+/* Returns the statistics in S for the size class with the given
+   BLOCK_SIZE. */
+static struct malloc_class_stats *
+find_class (struct malloc_stats *s, size_t block_size) 
+{
+  size_t i;
+
+  for (i = 0; i < s->class_cnt; i++)
+    if (s->classes[i].block_size == block_size)
+      return &s->classes[i];
+  fail ("no %zu-byte size class", block_size);
+  NOT_REACHED ();
+}
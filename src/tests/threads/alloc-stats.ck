@@ -0,0 +1,12 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(alloc-stats) begin
+(alloc-stats) Page allocator statistics OK.
+(alloc-stats) Small block statistics OK.
+(alloc-stats) Big block statistics OK.
+(alloc-stats) end
+EOF
+pass;
@@ -0,0 +1,87 @@
+/* Measures the cost of waking a herd of threads waiting on a
+   condition variable, for 10, 100, and 500 waiters.
+
+   The waiters have a higher priority than the main thread, so
+   each one that is made ready is entitled to preempt it.  The
+   test reports the number of CPU cycles that cond_broadcast()
+   itself takes, and the number until every waiter has
+   reacquired the lock and run. */
+
+#include <inttypes.h>
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "devices/timer.h"
+
+static struct lock lock;
+static struct condition cond;
+static int waiting_cnt;                 /* Waiters in cond_wait(). */
+static int woken_cnt;                   /* Waiters that have run. */
+static int herd_size;                   /* Waiters in this round. */
+static struct semaphore all_waiting;    /* Upped by last to wait. */
+static struct semaphore all_woken;      /* Upped by last to wake. */
+
+static void herd (int waiter_cnt);
+static void waiter (void *aux);
+
+void
+test_cond_herd (void) 
+{
+  ASSERT (!thread_mlfqs);
+
+  lock_init (&lock);
+  cond_init (&cond);
+  sema_init (&all_waiting, 0);
+  sema_init (&all_woken, 0);
+
+  herd (10);
+  herd (100);
+  herd (500);
+}
+
+/* Wakes WAITER_CNT waiters at once and reports the cost. */
+static void
+herd (int waiter_cnt) 
+{
+  uint64_t start, broadcast_cycles, herd_cycles;
+  int i;
+
+  herd_size = waiter_cnt;
+  waiting_cnt = woken_cnt = 0;
+  for (i = 0; i < waiter_cnt; i++) 
+    {
+      char name[32];
+      snprintf (name, sizeof name, "waiter %d", i);
+      if (thread_create (name, PRI_DEFAULT + 1, waiter, NULL) == TID_ERROR)
+        fail ("couldn't create thread %d of %d", i, waiter_cnt);
+    }
+  sema_down (&all_waiting);
+
+  lock_acquire (&lock);
+  start = timer_cycles ();
+  cond_broadcast (&cond, &lock);
+  broadcast_cycles = timer_cycles () - start;
+  lock_release (&lock);
+  sema_down (&all_woken);
+  herd_cycles = timer_cycles () - start;
+
+  msg ("%d waiters: broadcast took %"PRIu64" cycles, "
+       "all ran within %"PRIu64" cycles (%"PRIu64" per waiter).",
+       waiter_cnt, broadcast_cycles, herd_cycles,
+       herd_cycles / waiter_cnt);
+}
+
+/* Waits on the condition, then counts itself as woken. */
+static void
+waiter (void *aux UNUSED) 
+{
+  lock_acquire (&lock);
+  if (++waiting_cnt == herd_size)
+    sema_up (&all_waiting);
+  cond_wait (&cond, &lock);
+  if (++woken_cnt == herd_size)
+    sema_up (&all_woken);
+  lock_release (&lock);
+}
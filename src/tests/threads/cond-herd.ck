@@ -0,0 +1,16 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+
+our ($test);
+
+my (@output) = read_text_file ("$test.output");
+common_checks ("run", @output);
+@output = get_core_output ("run", @output);
+
+foreach my $waiter_cnt (10, 100, 500) {
+    fail "Missing wakeup cost for $waiter_cnt waiters.\n"
+      if !grep (/^\(cond-herd\) $waiter_cnt waiters: broadcast took \d+ cycles, all ran within \d+ cycles \(\d+ per waiter\)\.$/, @output);
+}
+pass;
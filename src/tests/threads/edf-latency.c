@@ -0,0 +1,120 @@
+/* Measures the delay between waking a thread and the thread
+   actually running, with the CPU crowded by a few threads that
+   spin at the same priority as the thread being woken.
+
+   A timeout wakes the main thread at irregular intervals and
+   records the time, in CPU cycles, at which it did so; the main
+   thread then records how long it took to get the CPU.  This is
+   done first with the main thread scheduled like any other,
+   which leaves it waiting behind the spinning threads, and then
+   with the main thread in the deadline scheduling class, which
+   should let it run as soon as the timer interrupt returns.  The
+   test reports percentiles of each distribution of delays, and
+   checks that admission control refuses a reservation that
+   would overcommit the CPU. */
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "devices/timer.h"
+
+#define SAMPLE_CNT 200          /* Wakeups measured per scheduler. */
+#define HOG_CNT 4               /* Spinning threads. */
+
+static uint64_t samples[SAMPLE_CNT]; /* Delays, in cycles. */
+static struct semaphore wakeup;      /* Upped by wake(). */
+static uint64_t wakeup_cycles;       /* When wake() last ran. */
+static bool stop;                    /* Tells hog threads to exit. */
+static struct semaphore exited;      /* Upped by each exiting hog. */
+
+static void measure (const char *scheduler);
+static void wake (void *aux);
+static void hog_thread (void *aux);
+static int compare_cycles (const void *, const void *);
+
+void
+test_edf_latency (void) 
+{
+  int i;
+
+  ASSERT (!thread_mlfqs);
+
+  sema_init (&wakeup, 0);
+  sema_init (&exited, 0);
+  for (i = 0; i < HOG_CNT; i++) 
+    {
+      char name[16];
+      snprintf (name, sizeof name, "hog %d", i);
+      thread_create (name, thread_get_priority (), hog_thread, NULL);
+    }
+
+  measure ("Default scheduler");
+
+  if (!thread_set_deadline (1, 4))
+    fail ("admission control refused a 25%% reservation");
+  measure ("Deadline class");
+  if (thread_set_deadline (10, 10))
+    fail ("admission control accepted a 100%% reservation");
+  msg ("Admission control refused a 100%% reservation.");
+  thread_clear_deadline ();
+
+  stop = true;
+  for (i = 0; i < HOG_CNT; i++)
+    sema_down (&exited);
+}
+
+/* Takes SAMPLE_CNT wakeup delay samples and reports their
+   distribution, labeled with SCHEDULER. */
+static void
+measure (const char *scheduler) 
+{
+  int i;
+
+  for (i = 0; i < SAMPLE_CNT; i++) 
+    {
+      struct timeout timeout;
+
+      memset (&timeout, 0, sizeof timeout);
+      timer_add (&timeout, timer_ticks () + 1 + i % 3, wake, NULL);
+      sema_down (&wakeup);
+      samples[i] = timer_cycles () - wakeup_cycles;
+    }
+
+  qsort (samples, SAMPLE_CNT, sizeof *samples, compare_cycles);
+  msg ("%s: %"PRIu64" cycles median, %"PRIu64" 90th percentile, "
+       "%"PRIu64" 99th percentile, %"PRIu64" maximum.", scheduler,
+       samples[SAMPLE_CNT / 2], samples[SAMPLE_CNT * 90 / 100],
+       samples[SAMPLE_CNT * 99 / 100], samples[SAMPLE_CNT - 1]);
+}
+
+/* Timeout function that wakes the main thread. */
+static void
+wake (void *aux UNUSED) 
+{
+  wakeup_cycles = timer_cycles ();
+  sema_up (&wakeup);
+}
+
+/* Spins until told to stop. */
+static void
+hog_thread (void *aux UNUSED) 
+{
+  while (!stop)
+    barrier ();
+  sema_up (&exited);
+}
+
+/* qsort() comparison function for cycle counts. */
+static int
+compare_cycles (const void *a_, const void *b_) 
+{
+  const uint64_t *a = a_;
+  const uint64_t *b = b_;
+
+  return *a < *b ? -1 : *a > *b;
+}
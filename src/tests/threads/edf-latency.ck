@@ -0,0 +1,26 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+
+our ($test);
+
+my (@output) = read_text_file ("$test.output");
+common_checks ("run", @output);
+@output = get_core_output ("run", @output);
+
+my (%p99);
+foreach (@output) {
+    my ($scheduler, $p99) = /^\(edf-latency\) (.*): \d+ cycles median, \d+ 90th percentile, (\d+) 99th percentile, \d+ maximum\.$/ or next;
+    $p99{$scheduler} = $p99;
+}
+foreach my $scheduler ("Default scheduler", "Deadline class") {
+    fail "Missing wakeup latency for \"$scheduler\".\n"
+      if !defined $p99{$scheduler};
+}
+fail "Deadline class did not reduce 99th percentile wakeup latency "
+  . "($p99{'Deadline class'} cycles versus $p99{'Default scheduler'}).\n"
+  if $p99{'Deadline class'} >= $p99{'Default scheduler'};
+fail "Admission control did not refuse an overcommitted reservation.\n"
+  if !grep (/^\(edf-latency\) Admission control refused a 100% reservation\.$/, @output);
+pass;
@@ -0,0 +1,105 @@
+/* Measures malloc() and free() throughput with 1 and with
+   THREAD_CNT threads allocating at once.
+
+   Each thread repeatedly allocates a handful of blocks, fills
+   them with a pattern, checks the pattern, and frees them.
+   64-byte blocks are served from the threads' magazines; 512-byte
+   blocks are too big to be cached, so every allocation and free
+   of one takes the size class's shared lock, which is the cost
+   the magazines avoid. */
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/malloc.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "devices/timer.h"
+
+#define THREAD_CNT 4            /* Threads in contended runs. */
+#define OP_CNT 20000            /* Allocations per run. */
+#define LIVE_CNT 6              /* Blocks each thread holds at once. */
+
+struct run 
+  {
+    size_t size;                /* Bytes per block. */
+    int ops;                    /* Allocations per thread. */
+    struct semaphore done;      /* Upped by each finished thread. */
+  };
+
+static int64_t run (size_t size, int thread_cnt);
+static void worker (void *);
+
+void
+test_malloc_bench (void) 
+{
+  static const size_t sizes[] = {64, 512};
+  size_t i;
+
+  for (i = 0; i < sizeof sizes / sizeof *sizes; i++) 
+    {
+      int64_t alone = run (sizes[i], 1);
+      int64_t contended = run (sizes[i], THREAD_CNT);
+
+      msg ("%zu-byte blocks: %"PRId64" ticks with 1 thread, "
+           "%"PRId64" ticks with %d threads.",
+           sizes[i], alone, contended, THREAD_CNT);
+    }
+}
+
+/* Has THREAD_CNT threads share OP_CNT allocations of SIZE bytes
+   and returns the number of ticks taken. */
+static int64_t
+run (size_t size, int thread_cnt) 
+{
+  struct run r;
+  int64_t start;
+  int i;
+
+  r.size = size;
+  r.ops = OP_CNT / thread_cnt;
+  sema_init (&r.done, 0);
+
+  start = timer_ticks ();
+  for (i = 0; i < thread_cnt; i++) 
+    {
+      char name[32];
+      snprintf (name, sizeof name, "malloc %d", i);
+      if (thread_create (name, PRI_DEFAULT, worker, &r) == TID_ERROR)
+        fail ("thread_create failed");
+    }
+  for (i = 0; i < thread_cnt; i++)
+    sema_down (&r.done);
+  return timer_elapsed (start);
+}
+
+static void
+worker (void *r_) 
+{
+  struct run *r = r_;
+  unsigned char pattern = thread_tid ();
+  int i, j;
+
+  for (i = 0; i < r->ops; i += LIVE_CNT) 
+    {
+      unsigned char *blocks[LIVE_CNT];
+
+      for (j = 0; j < LIVE_CNT; j++) 
+        {
+          blocks[j] = malloc (r->size);
+          if (blocks[j] == NULL)
+            fail ("malloc failed");
+          memset (blocks[j], pattern + j, r->size);
+        }
+      for (j = 0; j < LIVE_CNT; j++) 
+        {
+          if (blocks[j][0] != (unsigned char) (pattern + j)
+              || blocks[j][r->size - 1] != (unsigned char) (pattern + j))
+            fail ("block %d overwritten", j);
+          free (blocks[j]);
+        }
+    }
+  sema_up (&r->done);
+}
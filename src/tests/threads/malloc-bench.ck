@@ -0,0 +1,16 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+
+our ($test);
+
+my (@output) = read_text_file ("$test.output");
+common_checks ("run", @output);
+@output = get_core_output ("run", @output);
+
+foreach my $size (64, 512) {
+    fail "Missing timings for $size-byte blocks.\n"
+      if !grep (/^\(malloc-bench\) $size-byte blocks: \d+ ticks with 1 thread, \d+ ticks with 4 threads\.$/, @output);
+}
+pass;
@@ -0,0 +1,90 @@
+/* Measures the cost of the timer interrupt under the multi-level
+   feedback queue scheduler as the number of threads grows.  For
+   each thread count, starts that many threads that alternately
+   spin and sleep, as in mlfqs-load-60, and reports the average
+   and maximum number of CPU cycles spent per timer interrupt
+   over a few seconds.  With bookkeeping that does a constant
+   amount of work per tick, the maximum, which includes the
+   once-a-second updates, should not grow with the number of
+   threads. */
+
+#include <inttypes.h>
+#include <random.h>
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/malloc.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "devices/timer.h"
+
+/* Seconds to measure for at each thread count. */
+#define MEASURE_SECONDS 4
+
+static bool stop;                       /* Tells load threads to exit. */
+static struct semaphore exited;         /* Upped by each exiting thread. */
+
+static void measure (int thread_cnt);
+static void load_thread (void *aux);
+
+void
+test_mlfqs_tick_cost (void) 
+{
+  ASSERT (thread_mlfqs);
+
+  thread_set_nice (NICE_MIN);
+  sema_init (&exited, 0);
+
+  measure (1);
+  measure (10);
+  measure (50);
+  measure (150);
+}
+
+/* Reports the timer interrupt cost with THREAD_CNT load threads
+   running. */
+static void
+measure (int thread_cnt) 
+{
+  int64_t intr_cnt;
+  uint64_t avg_cycles, max_cycles;
+  int i;
+
+  stop = false;
+  for (i = 0; i < thread_cnt; i++) 
+    {
+      char name[16];
+      snprintf (name, sizeof name, "load %d", i);
+      if (thread_create (name, PRI_DEFAULT, load_thread, NULL) == TID_ERROR)
+        fail ("couldn't create thread %d of %d", i, thread_cnt);
+    }
+
+  /* Let the load settle, then measure. */
+  timer_sleep (TIMER_FREQ);
+  timer_intr_stats_reset ();
+  timer_sleep (MEASURE_SECONDS * TIMER_FREQ);
+  timer_intr_stats (&intr_cnt, &avg_cycles, &max_cycles);
+
+  stop = true;
+  for (i = 0; i < thread_cnt; i++)
+    sema_down (&exited);
+
+  msg ("%d threads: %"PRId64" ticks, %"PRIu64" cycles/tick average, "
+       "%"PRIu64" maximum.", thread_cnt, intr_cnt, avg_cycles, max_cycles);
+}
+
+/* Spins for a few ticks, then sleeps for a few ticks, until told
+   to stop. */
+static void
+load_thread (void *aux UNUSED) 
+{
+  thread_set_nice (5);
+  while (!stop) 
+    {
+      int64_t spin_until = timer_ticks () + 1 + random_ulong () % 8;
+      while (!stop && timer_ticks () < spin_until)
+        continue;
+      timer_sleep (1 + random_ulong () % 8);
+    }
+  sema_up (&exited);
+}
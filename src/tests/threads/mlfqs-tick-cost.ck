@@ -0,0 +1,16 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+
+our ($test);
+
+my (@output) = read_text_file ("$test.output");
+common_checks ("run", @output);
+@output = get_core_output ("run", @output);
+
+foreach my $thread_cnt (1, 10, 50, 150) {
+    fail "Missing timer interrupt cost with $thread_cnt threads.\n"
+      if !grep (/^\(mlfqs-tick-cost\) $thread_cnt threads: \d+ ticks, \d+ cycles\/tick average, \d+ maximum\.$/, @output);
+}
+pass;
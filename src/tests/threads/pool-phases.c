@@ -0,0 +1,52 @@
+/* Alternates phases in which the kernel and then user processes
+   each want most of memory, with the other class idle, and
+   counts the allocations that fail.
+
+   Each phase asks for three-fifths of all the pages in the pool,
+   one at a time, then frees them.  With memory split in half
+   between fixed kernel and user pools, about a sixth of every
+   phase's requests would fail.  With a shared pool, each class
+   can borrow the pages that the other is not using, so every
+   request should succeed. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/palloc.h"
+
+#define PHASE_CNT 6             /* Number of phases. */
+#define PAGE_MAX 4096           /* Most pages a phase can ask for. */
+
+static void *pages[PAGE_MAX];
+
+void
+test_pool_phases (void) 
+{
+  struct palloc_stats s;
+  size_t want, i;
+  int phase;
+
+  palloc_get_stats (0, &s);
+  want = s.page_cnt * 3 / 5;
+  if (want > PAGE_MAX)
+    want = PAGE_MAX;
+
+  for (phase = 0; phase < PHASE_CNT; phase++) 
+    {
+      enum palloc_flags flags = phase % 2 == 0 ? 0 : PAL_USER;
+      size_t got = 0;
+
+      for (i = 0; i < want; i++) 
+        {
+          void *page = palloc_get_page (flags);
+          if (page != NULL)
+            pages[got++] = page;
+        }
+      msg ("Phase %d, %s pages: %zu of %zu allocations failed.",
+           phase + 1, flags & PAL_USER ? "user" : "kernel",
+           want - got, want);
+
+      for (i = 0; i < got; i++)
+        palloc_free_page (pages[i]);
+    }
+}
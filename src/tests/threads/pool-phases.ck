@@ -0,0 +1,20 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+
+our ($test);
+
+my (@output) = read_text_file ("$test.output");
+common_checks ("run", @output);
+@output = get_core_output ("run", @output);
+
+foreach my $phase (1...6) {
+    my ($class) = $phase % 2 ? "kernel" : "user";
+    my ($line) = grep (/^\(pool-phases\) Phase $phase, $class pages:/, @output);
+    fail "Missing phase $phase.\n" if !defined $line;
+    my ($failed) = $line =~ /: (\d+) of \d+ allocations failed\.$/
+      or fail "Malformed phase $phase line.\n";
+    fail "$failed allocations failed in phase $phase.\n" if $failed > 0;
+}
+pass;
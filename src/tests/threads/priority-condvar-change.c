@@ -0,0 +1,71 @@
+/* Tests that a thread's place among a condition variable's
+   waiters follows its priority when that priority changes
+   between cond_wait() queuing the thread and the thread going
+   to sleep.
+
+   A low-priority thread acquires the lock and then receives a
+   high priority by donation from a thread that waits for the
+   lock.  It calls cond_wait(), which queues it with the donated
+   priority, and then releases the lock, which drops it back to
+   its own priority before it sleeps.  cond_signal() must then
+   wake it after the waiters of intermediate priority, not
+   before them. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+
+static thread_func waiter_thread;
+static thread_func donor_thread;
+static struct lock lock;
+static struct condition condition;
+
+void
+test_priority_condvar_change (void) 
+{
+  int i;
+
+  /* This test does not work with the MLFQS. */
+  ASSERT (!thread_mlfqs);
+
+  lock_init (&lock);
+  cond_init (&condition);
+
+  thread_create ("waiter 40", PRI_DEFAULT + 9, waiter_thread, NULL);
+  thread_create ("waiter 36", PRI_DEFAULT + 5, waiter_thread, NULL);
+  thread_create ("waiter 33", PRI_DEFAULT + 2, waiter_thread, NULL);
+
+  for (i = 0; i < 3; i++) 
+    {
+      lock_acquire (&lock);
+      msg ("Signaling...");
+      cond_signal (&condition, &lock);
+      lock_release (&lock);
+    }
+}
+
+/* Waits on the condition.  The lowest-priority waiter first has
+   a donor raise its priority while it holds the lock. */
+static void
+waiter_thread (void *aux UNUSED) 
+{
+  lock_acquire (&lock);
+  if (thread_get_priority () == PRI_DEFAULT + 2)
+    thread_create ("donor", PRI_DEFAULT + 19, donor_thread, NULL);
+  msg ("Thread %s waiting with priority %d.",
+       thread_name (), thread_get_priority ());
+  cond_wait (&condition, &lock);
+  msg ("Thread %s woke up.", thread_name ());
+  lock_release (&lock);
+}
+
+/* Donates its priority to the holder of the lock. */
+static void
+donor_thread (void *aux UNUSED) 
+{
+  lock_acquire (&lock);
+  msg ("Thread %s got the lock.", thread_name ());
+  lock_release (&lock);
+}
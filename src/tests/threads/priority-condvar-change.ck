@@ -0,0 +1,19 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(priority-condvar-change) begin
+(priority-condvar-change) Thread waiter 40 waiting with priority 40.
+(priority-condvar-change) Thread waiter 36 waiting with priority 36.
+(priority-condvar-change) Thread waiter 33 waiting with priority 50.
+(priority-condvar-change) Thread donor got the lock.
+(priority-condvar-change) Signaling...
+(priority-condvar-change) Thread waiter 40 woke up.
+(priority-condvar-change) Signaling...
+(priority-condvar-change) Thread waiter 36 woke up.
+(priority-condvar-change) Signaling...
+(priority-condvar-change) Thread waiter 33 woke up.
+(priority-condvar-change) end
+EOF
+pass;
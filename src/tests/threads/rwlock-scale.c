@@ -0,0 +1,158 @@
+/* Compares a reader-writer lock against a plain lock as the
+   protection for a shared structure whose critical sections
+   block, as they would while reading an inode from disk.
+
+   THREAD_CNT threads each perform OP_CNT operations, of which a
+   given percentage are reads.  Every operation sleeps for a tick
+   inside its critical section.  Under a lock, all operations are
+   serialized, so the run takes about THREAD_CNT * OP_CNT ticks
+   whatever the mix.  Under a reader-writer lock, readers overlap,
+   so the run should get shorter as the fraction of reads grows.
+   Half of the rwlock writes are done by upgrading a read hold and
+   then downgrading it again.
+
+   Each critical section also checks that no writer overlaps any
+   other thread. */
+
+#include <stdio.h>
+#include <inttypes.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "devices/timer.h"
+
+#define THREAD_CNT 8
+#define OP_CNT 16
+
+struct shared 
+  {
+    bool use_rwlock;            /* Use rwlock instead of lock? */
+    int read_pct;               /* Percentage of reads. */
+    struct lock lock;
+    struct rwlock rwlock;
+    int readers;                /* Readers inside critical section. */
+    int writers;                /* Writers inside critical section. */
+    struct semaphore done;      /* Upped by each finished thread. */
+  };
+
+static int64_t run (bool use_rwlock, int read_pct);
+static void worker (void *);
+static void read_section (struct shared *);
+static void write_section (struct shared *);
+
+void
+test_rwlock_scale (void) 
+{
+  static const int read_pcts[] = {0, 50, 90, 100};
+  size_t i;
+
+  for (i = 0; i < sizeof read_pcts / sizeof *read_pcts; i++) 
+    {
+      int64_t lock_ticks = run (false, read_pcts[i]);
+      int64_t rwlock_ticks = run (true, read_pcts[i]);
+
+      msg ("%d%% reads: %"PRId64" ticks with lock, "
+           "%"PRId64" ticks with rwlock.",
+           read_pcts[i], lock_ticks, rwlock_ticks);
+    }
+}
+
+/* Runs THREAD_CNT workers doing READ_PCT percent reads,
+   protected by a reader-writer lock if USE_RWLOCK is true or by
+   a lock otherwise, and returns the number of ticks taken. */
+static int64_t
+run (bool use_rwlock, int read_pct) 
+{
+  struct shared shared;
+  int64_t start;
+  int i;
+
+  shared.use_rwlock = use_rwlock;
+  shared.read_pct = read_pct;
+  lock_init (&shared.lock);
+  rwlock_init (&shared.rwlock);
+  shared.readers = shared.writers = 0;
+  sema_init (&shared.done, 0);
+
+  start = timer_ticks ();
+  for (i = 0; i < THREAD_CNT; i++) 
+    {
+      char name[16];
+      snprintf (name, sizeof name, "worker %d", i);
+      thread_create (name, PRI_DEFAULT, worker, &shared);
+    }
+  for (i = 0; i < THREAD_CNT; i++)
+    sema_down (&shared.done);
+  return timer_elapsed (start);
+}
+
+static void
+worker (void *shared_) 
+{
+  struct shared *shared = shared_;
+  int i;
+
+  for (i = 0; i < OP_CNT; i++) 
+    {
+      bool read = (i * 100 / OP_CNT + thread_tid ()) % 100 < shared->read_pct;
+
+      if (!shared->use_rwlock) 
+        {
+          lock_acquire (&shared->lock);
+          if (read)
+            read_section (shared);
+          else
+            write_section (shared);
+          lock_release (&shared->lock);
+        }
+      else if (read) 
+        {
+          rwlock_acquire_read (&shared->rwlock);
+          read_section (shared);
+          rwlock_release_read (&shared->rwlock);
+        }
+      else 
+        {
+          if (i % 2 != 0) 
+            {
+              rwlock_acquire_read (&shared->rwlock);
+              if (rwlock_upgrade (&shared->rwlock)) 
+                {
+                  write_section (shared);
+                  rwlock_downgrade (&shared->rwlock);
+                  read_section (shared);
+                  rwlock_release_read (&shared->rwlock);
+                  continue;
+                }
+              rwlock_release_read (&shared->rwlock);
+            }
+          rwlock_acquire_write (&shared->rwlock);
+          write_section (shared);
+          rwlock_release_write (&shared->rwlock);
+        }
+    }
+  sema_up (&shared->done);
+}
+
+/* Reads the shared structure. */
+static void
+read_section (struct shared *shared) 
+{
+  shared->readers++;
+  if (shared->writers != 0)
+    fail ("reader overlapped a writer");
+  timer_sleep (1);
+  shared->readers--;
+}
+
+/* Writes the shared structure. */
+static void
+write_section (struct shared *shared) 
+{
+  shared->writers++;
+  if (shared->writers != 1 || shared->readers != 0)
+    fail ("writer overlapped another thread");
+  timer_sleep (1);
+  shared->writers--;
+}
@@ -0,0 +1,23 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+
+our ($test);
+
+my (@output) = read_text_file ("$test.output");
+common_checks ("run", @output);
+@output = get_core_output ("run", @output);
+
+my (%lock, %rwlock);
+foreach (@output) {
+    my ($pct, $lock, $rwlock) = /^\(rwlock-scale\) (\d+)% reads: (\d+) ticks with lock, (\d+) ticks with rwlock\.$/ or next;
+    ($lock{$pct}, $rwlock{$pct}) = ($lock, $rwlock);
+}
+foreach my $pct (0, 50, 90, 100) {
+    fail "Missing timing for $pct% reads.\n" if !defined $lock{$pct};
+}
+fail "rwlock with only readers ($rwlock{100} ticks) was not faster "
+  . "than lock ($lock{100} ticks).\n"
+  if $rwlock{100} * 2 > $lock{100};
+pass;
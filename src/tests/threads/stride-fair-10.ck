@@ -0,0 +1,7 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+use tests::threads::stride;
+
+check_stride_fair ([10, 20, 30, 40, 50, 60, 70, 80, 90, 100], 50);
@@ -0,0 +1,129 @@
+/* Measures the fairness of the stride scheduler.
+
+   The stride-fair-4 test runs 4 threads holding 100, 200, 300,
+   and 400 tickets, and the stride-fair-10 test runs 10 threads
+   holding 10, 20, ..., 100 tickets.  Each thread should receive
+   a share of the 30 seconds of spinning, 30 * 100 == 3000 ticks,
+   in proportion to its tickets: 300, 600, 900, and 1,200 ticks
+   in the first test.
+
+   Besides each thread's tick count, the test reports the largest
+   share error, as a fraction of that thread's expected ticks,
+   and the average and maximum number of CPU cycles spent in the
+   timer interrupt per tick while the threads were spinning. */
+
+#include <stdio.h>
+#include <inttypes.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/malloc.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "devices/timer.h"
+
+static void test_stride_fair (int thread_cnt, int tickets_step);
+
+void
+test_stride_fair_4 (void) 
+{
+  test_stride_fair (4, 100);
+}
+
+void
+test_stride_fair_10 (void) 
+{
+  test_stride_fair (10, 10);
+}
+
+#define MAX_THREAD_CNT 10
+
+struct thread_info 
+  {
+    int64_t start_time;
+    int tick_count;
+    int tickets;
+  };
+
+static void load_thread (void *aux);
+
+static void
+test_stride_fair (int thread_cnt, int tickets_step)
+{
+  struct thread_info info[MAX_THREAD_CNT];
+  int64_t start_time, intr_cnt;
+  uint64_t avg_cycles, max_cycles;
+  int total_ticks, total_tickets;
+  int max_error;
+  int i;
+
+  ASSERT (thread_stride);
+  ASSERT (thread_cnt <= MAX_THREAD_CNT);
+  ASSERT (tickets_step * thread_cnt <= TICKETS_MAX);
+
+  start_time = timer_ticks ();
+  msg ("Starting %d threads...", thread_cnt);
+  for (i = 0; i < thread_cnt; i++) 
+    {
+      struct thread_info *ti = &info[i];
+      char name[16];
+
+      ti->start_time = start_time;
+      ti->tick_count = 0;
+      ti->tickets = tickets_step * (i + 1);
+
+      snprintf(name, sizeof name, "load %d", i);
+      thread_create (name, PRI_DEFAULT, load_thread, ti);
+    }
+  msg ("Starting threads took %"PRId64" ticks.", timer_elapsed (start_time));
+
+  msg ("Sleeping 40 seconds to let threads run, please wait...");
+  timer_sleep (5 * TIMER_FREQ - timer_elapsed (start_time));
+  timer_intr_stats_reset ();
+  timer_sleep (35 * TIMER_FREQ - timer_elapsed (start_time));
+  timer_intr_stats (&intr_cnt, &avg_cycles, &max_cycles);
+  timer_sleep (40 * TIMER_FREQ - timer_elapsed (start_time));
+
+  total_ticks = total_tickets = 0;
+  for (i = 0; i < thread_cnt; i++) 
+    {
+      total_ticks += info[i].tick_count;
+      total_tickets += info[i].tickets;
+    }
+
+  /* Share error in tenths of a percent of the expected ticks. */
+  max_error = 0;
+  for (i = 0; i < thread_cnt; i++) 
+    {
+      int expected = total_ticks * info[i].tickets / total_tickets;
+      int error = info[i].tick_count - expected;
+
+      if (error < 0)
+        error = -error;
+      error = expected > 0 ? error * 1000 / expected : 0;
+      if (error > max_error)
+        max_error = error;
+      msg ("Thread %d received %d ticks.", i, info[i].tick_count);
+    }
+  msg ("Largest share error: %d.%d%%.", max_error / 10, max_error % 10);
+  msg ("Timer interrupt: %"PRIu64" cycles/tick average, "
+       "%"PRIu64" maximum.", avg_cycles, max_cycles);
+}
+
+static void
+load_thread (void *ti_) 
+{
+  struct thread_info *ti = ti_;
+  int64_t sleep_time = 5 * TIMER_FREQ;
+  int64_t spin_time = sleep_time + 30 * TIMER_FREQ;
+  int64_t last_time = 0;
+
+  thread_set_tickets (ti->tickets);
+  timer_sleep (sleep_time - timer_elapsed (ti->start_time));
+  while (timer_elapsed (ti->start_time) < spin_time) 
+    {
+      int64_t cur_time = timer_ticks ();
+      if (cur_time != last_time)
+        ti->tick_count++;
+      last_time = cur_time;
+    }
+}
@@ -0,0 +1,50 @@
+# -*- perl -*-
+use strict;
+use warnings;
+
+# Checks that each thread in a stride-fair test received a share
+# of the ticks that all of them received in proportion to its
+# tickets, within $maxdiff ticks.
+sub check_stride_fair {
+    my ($tickets, $maxdiff) = @_;
+    our ($test);
+    my (@output) = read_text_file ("$test.output");
+    common_checks ("run", @output);
+    @output = get_core_output ("run", @output);
+
+    my (@actual);
+    local ($_);
+    foreach (@output) {
+	my ($id, $count) = /Thread (\d+) received (\d+) ticks\./ or next;
+        $actual[$id] = $count;
+    }
+
+    my ($total_ticks) = 0;
+    my ($total_tickets) = 0;
+    for my $i (0...$#$tickets) {
+	fail "Thread $i did not report its tick count.\n"
+	  if !defined $actual[$i];
+	$total_ticks += $actual[$i];
+	$total_tickets += $tickets->[$i];
+    }
+
+    my ($ok) = 1;
+    my (@expected);
+    for my $i (0...$#$tickets) {
+	$expected[$i] = $total_ticks * $tickets->[$i] / $total_tickets;
+	$ok = 0 if abs ($actual[$i] - $expected[$i]) > $maxdiff;
+    }
+    if (!$ok) {
+	my ($msg) = "Some tick counts differed from those expected "
+	  . "by more than $maxdiff.\n";
+	for my $i (0...$#$tickets) {
+	    $msg .= sprintf ("Thread %d (%d tickets): %d ticks, "
+			     . "expected %.0f.\n",
+			     $i, $tickets->[$i], $actual[$i], $expected[$i]);
+	}
+	fail $msg;
+    }
+    pass;
+}
+
+1;
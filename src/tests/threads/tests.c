@@ -38,6 +38,21 @@ static const struct test tests[] =
     {"mlfqs-nice-2", test_mlfqs_nice_2},
     {"mlfqs-nice-10", test_mlfqs_nice_10},
     {"mlfqs-block", test_mlfqs_block},
+    {"mlfqs-tick-cost", test_mlfqs_tick_cost},
+    {"timeout-stress", test_timeout_stress},
+    {"stride-fair-4", test_stride_fair_4},
+    {"stride-fair-10", test_stride_fair_10},
+    {"edf-latency", test_edf_latency},
+    {"rwlock-scale", test_rwlock_scale},
+    {"cond-herd", test_cond_herd},
+    {"work-queue", test_work_queue},
+    {"thread-churn", test_thread_churn},
+    {"malloc-bench", test_malloc_bench},
+    {"alloc-stats", test_alloc_stats},
+    {"pool-phases", test_pool_phases},
+    {"tlb-refill", test_tlb_refill},
+    {"timeout-rearm", test_timeout_rearm},
+    {"priority-condvar-change", test_priority_condvar_change},
   };
 
 static const char *test_name;
@@ -32,6 +32,21 @@ extern test_func test_mlfqs_fair_20;
 extern test_func test_mlfqs_nice_2;
 extern test_func test_mlfqs_nice_10;
 extern test_func test_mlfqs_block;
+extern test_func test_mlfqs_tick_cost;
+extern test_func test_timeout_stress;
+extern test_func test_stride_fair_4;
+extern test_func test_stride_fair_10;
+extern test_func test_edf_latency;
+extern test_func test_rwlock_scale;
+extern test_func test_cond_herd;
+extern test_func test_work_queue;
+extern test_func test_thread_churn;
+extern test_func test_malloc_bench;
+extern test_func test_alloc_stats;
+extern test_func test_pool_phases;
+extern test_func test_tlb_refill;
+extern test_func test_timeout_rearm;
+extern test_func test_priority_condvar_change;
 
 void msg (const char *, ...);
 void fail (const char *, ...);
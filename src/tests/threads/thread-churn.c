@@ -0,0 +1,55 @@
+/* Creates and reaps thread after thread, in waves of WAVE_SIZE,
+   to exercise thread creation and exit.  The pages of threads
+   that exit are recycled through the thread page cache, so after
+   the first wave almost every thread should get a reused page.
+   The time taken is printed to the console, outside the checked
+   output, for comparing kernels. */
+
+#include <inttypes.h>
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "devices/timer.h"
+
+#define WAVE_SIZE 8             /* Threads alive at once. */
+#define WAVE_CNT 250            /* Number of waves. */
+
+static void churn_thread (void *done_);
+
+void
+test_thread_churn (void) 
+{
+  struct semaphore done;
+  int64_t start;
+  int i, j;
+
+  sema_init (&done, 0);
+  start = timer_ticks ();
+  for (i = 0; i < WAVE_CNT; i++) 
+    {
+      for (j = 0; j < WAVE_SIZE; j++) 
+        {
+          char name[16];
+
+          snprintf (name, sizeof name, "churn %d", j);
+          if (thread_create (name, PRI_DEFAULT, churn_thread, &done)
+              == TID_ERROR)
+            fail ("thread_create failed in wave %d", i);
+        }
+      for (j = 0; j < WAVE_SIZE; j++)
+        sema_down (&done);
+    }
+  msg ("Created and reaped %d threads in %"PRId64" ticks.",
+       WAVE_SIZE * WAVE_CNT, timer_elapsed (start));
+}
+
+/* Thread function that signals DONE_ and exits. */
+static void
+churn_thread (void *done_) 
+{
+  struct semaphore *done = done_;
+
+  sema_up (done);
+}
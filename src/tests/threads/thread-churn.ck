@@ -0,0 +1,15 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+
+our ($test);
+
+my (@output) = read_text_file ("$test.output");
+common_checks ("run", @output);
+@output = get_core_output ("run", @output);
+
+fail "Missing thread count.\n"
+  if !grep (/^\(thread-churn\) Created and reaped 2000 threads in \d+ ticks\.$/,
+            @output);
+pass;
@@ -0,0 +1,59 @@
+/* Arms a timeout whose function rearms it, each time with a
+   deadline that has already passed, and checks that it runs
+   again at the very next tick every time, as timer_add()
+   promises, instead of waiting for the timer wheel to come
+   around. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "devices/timer.h"
+
+#define RUN_CNT 100             /* Number of times to run. */
+
+static struct timeout rearm_to;
+static struct semaphore done;
+static int64_t run_ticks[RUN_CNT];
+static int run_cnt;
+
+static timeout_func rearm_timeout;
+
+void
+test_timeout_rearm (void) 
+{
+  int late_cnt = 0;
+  int i;
+
+  sema_init (&done, 0);
+  timer_add (&rearm_to, timer_ticks () + 1, rearm_timeout, NULL);
+  sema_down (&done);
+
+  for (i = 1; i < RUN_CNT; i++)
+    if (run_ticks[i] != run_ticks[i - 1] + 1)
+      {
+        if (late_cnt++ == 0)
+          msg ("run %d came %lld ticks after run %d", i,
+               (long long) (run_ticks[i] - run_ticks[i - 1]), i - 1);
+      }
+  if (late_cnt > 0)
+    fail ("%d of %d overdue rearms did not run at the next tick",
+          late_cnt, RUN_CNT - 1);
+  msg ("%d overdue rearms all ran at the next tick.", RUN_CNT - 1);
+}
+
+/* Records the current tick and rearms itself with a deadline
+   in the past, alternating between the current tick and an
+   earlier one, until it has run RUN_CNT times. */
+static void
+rearm_timeout (void *aux UNUSED) 
+{
+  int64_t now = timer_ticks ();
+
+  run_ticks[run_cnt++] = now;
+  if (run_cnt < RUN_CNT)
+    timer_add (&rearm_to, run_cnt % 2 ? now : now - 10, rearm_timeout,
+               NULL);
+  else
+    sema_up (&done);
+}
@@ -0,0 +1,10 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(timeout-rearm) begin
+(timeout-rearm) 99 overdue rearms all ran at the next tick.
+(timeout-rearm) end
+EOF
+pass;
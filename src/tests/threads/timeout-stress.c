@@ -0,0 +1,118 @@
+/* Arms thousands of timeouts with deadlines spread over every
+   level of the timer wheel, then cancels and rearms them at a
+   high rate for several seconds.  Verifies that every timeout
+   that runs does so exactly at its deadline, and reports the
+   cost of the timer interrupt per tick, which should not grow
+   with the number of armed timeouts. */
+
+#include <inttypes.h>
+#include <random.h>
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/interrupt.h"
+#include "threads/malloc.h"
+#include "threads/thread.h"
+#include "devices/timer.h"
+
+#define TIMEOUT_CNT 10000
+#define STRESS_TICKS (5 * TIMER_FREQ)
+
+static long long run_cnt;       /* # of timeouts that ran. */
+static long long wrong_cnt;     /* # that ran early or late. */
+
+static void report_cost (const char *what);
+static int64_t random_deadline (void);
+static timeout_func stress_timeout;
+
+void
+test_timeout_stress (void) 
+{
+  struct timeout *timeouts;
+  long long rearm_cnt;
+  int64_t start;
+  int i;
+
+  timeouts = calloc (TIMEOUT_CNT, sizeof *timeouts);
+  if (timeouts == NULL)
+    fail ("couldn't allocate %d timeouts", TIMEOUT_CNT);
+
+  /* Baseline: nothing armed. */
+  timer_intr_stats_reset ();
+  timer_sleep (TIMER_FREQ);
+  report_cost ("no timeouts armed");
+
+  /* Arm everything. */
+  for (i = 0; i < TIMEOUT_CNT; i++)
+    timer_add (&timeouts[i], random_deadline (), stress_timeout,
+               &timeouts[i]);
+  timer_intr_stats_reset ();
+  timer_sleep (TIMER_FREQ);
+  report_cost ("10000 timeouts armed");
+
+  /* Cancel and rearm random timeouts as fast as we can. */
+  msg ("Rearming timeouts for %d seconds...", STRESS_TICKS / TIMER_FREQ);
+  timer_intr_stats_reset ();
+  rearm_cnt = 0;
+  start = timer_ticks ();
+  while (timer_elapsed (start) < STRESS_TICKS) 
+    {
+      struct timeout *to = &timeouts[random_ulong () % TIMEOUT_CNT];
+      timer_cancel (to);
+      timer_add (to, random_deadline (), stress_timeout, to);
+      rearm_cnt++;
+    }
+  report_cost ("rearming under way");
+
+  for (i = 0; i < TIMEOUT_CNT; i++)
+    timer_cancel (&timeouts[i]);
+  free (timeouts);
+
+  if (rearm_cnt == 0 || run_cnt == 0)
+    fail ("no timeouts were rearmed or run");
+  msg ("%lld timeouts canceled and rearmed in %d seconds.",
+       rearm_cnt, STRESS_TICKS / TIMER_FREQ);
+  if (wrong_cnt != 0)
+    fail ("%lld of %lld timeouts ran early or late", wrong_cnt, run_cnt);
+  msg ("All timeouts ran exactly on time.");
+}
+
+/* Prints the timer interrupt cost since the last reset. */
+static void
+report_cost (const char *what) 
+{
+  int64_t intr_cnt;
+  uint64_t avg_cycles, max_cycles;
+
+  timer_intr_stats (&intr_cnt, &avg_cycles, &max_cycles);
+  msg ("Timer interrupt with %s: %"PRIu64" cycles/tick average, "
+       "%"PRIu64" maximum.", what, avg_cycles, max_cycles);
+}
+
+/* Returns a deadline from the near future, for timeouts that
+   run during the test, or from the far future, to populate the
+   upper levels of the wheel. */
+static int64_t
+random_deadline (void) 
+{
+  unsigned long r = random_ulong ();
+  int64_t delay;
+
+  if (r % 2 == 0)
+    delay = 1 + (r >> 1) % STRESS_TICKS;
+  else
+    delay = 1 + (r >> 1) % (1000 * TIMER_FREQ);
+  return timer_ticks () + delay;
+}
+
+/* Timeout function.  Checks that it runs at its deadline. */
+static void
+stress_timeout (void *to_) 
+{
+  struct timeout *to = to_;
+
+  ASSERT (intr_context ());
+  run_cnt++;
+  if (timer_ticks () != to->deadline)
+    wrong_cnt++;
+}
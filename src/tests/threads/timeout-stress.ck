@@ -0,0 +1,19 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+
+our ($test);
+
+my (@output) = read_text_file ("$test.output");
+common_checks ("run", @output);
+@output = get_core_output ("run", @output);
+
+foreach my $what ("no timeouts armed", "10000 timeouts armed",
+		  "rearming under way") {
+    fail "Missing timer interrupt cost with $what.\n"
+      if !grep (/Timer interrupt with $what: \d+ cycles\/tick average, \d+ maximum\./, @output);
+}
+fail "Timeouts were not all rearmed and run on time.\n"
+  if !grep (/All timeouts ran exactly on time\./, @output);
+pass;
@@ -0,0 +1,139 @@
+/* Measures how much it costs to refill the TLB with kernel
+   mappings after an address-space switch, with the kernel's
+   mappings global, as paging_init() makes them, and then with
+   global pages turned off.
+
+   Kernel threads all run in the base page directory, so the test
+   reloads CR3 itself wherever a process switch would, by calling
+   cpu_flush_tlb().  It then touches pages spread across the
+   kernel's map of physical memory.  With global pages, those
+   translations survive the reload; without them, every touch
+   after a reload walks the page tables again.
+
+   The first measurement reloads CR3 and sweeps SWEEP_PAGES pages
+   in a loop.  The second ping-pongs between two threads, each of
+   which reloads CR3 and touches a smaller working set on every
+   switch. */
+
+#include <inttypes.h>
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/cpu.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "threads/vaddr.h"
+#include "devices/timer.h"
+
+#define SWEEP_PAGES 256         /* Pages touched per sweep. */
+#define SWEEP_CNT 200           /* Number of sweeps. */
+#define SWITCH_PAGES 32         /* Pages touched per switch. */
+#define SWITCH_CNT 1000         /* Number of round trips. */
+
+static void touch_pages (size_t page_cnt);
+static uint64_t measure_sweeps (void);
+static uint64_t measure_switches (void);
+
+void
+test_tlb_refill (void) 
+{
+  uint32_t cr4 = cpu_get_cr4 ();
+  uint64_t global_sweep, global_switch;
+  uint64_t plain_sweep, plain_switch;
+
+  if (!(cr4 & CR4_PGE)) 
+    {
+      msg ("Global pages not supported.");
+      return;
+    }
+
+  global_sweep = measure_sweeps ();
+  global_switch = measure_switches ();
+
+  cpu_set_cr4 (cr4 & ~CR4_PGE);
+  plain_sweep = measure_sweeps ();
+  plain_switch = measure_switches ();
+  cpu_set_cr4 (cr4);
+
+  msg ("Sweep after CR3 load: %"PRIu64" cycles global, "
+       "%"PRIu64" cycles not global.",
+       global_sweep / SWEEP_CNT, plain_sweep / SWEEP_CNT);
+  msg ("Context switch: %"PRIu64" cycles global, "
+       "%"PRIu64" cycles not global.",
+       global_switch / (2 * SWITCH_CNT), plain_switch / (2 * SWITCH_CNT));
+}
+
+/* Reads one byte from each of PAGE_CNT pages spread evenly
+   across physical memory. */
+static void
+touch_pages (size_t page_cnt) 
+{
+  size_t stride = ram_pages / page_cnt;
+  size_t i;
+
+  for (i = 0; i < page_cnt; i++)
+    *(volatile uint8_t *) ptov (i * stride * PGSIZE);
+}
+
+/* Returns the cycles taken by SWEEP_CNT sweeps, each following
+   a CR3 reload. */
+static uint64_t
+measure_sweeps (void) 
+{
+  uint64_t start = timer_cycles ();
+  int i;
+
+  for (i = 0; i < SWEEP_CNT; i++) 
+    {
+      cpu_flush_tlb ();
+      touch_pages (SWEEP_PAGES);
+    }
+  return timer_cycles () - start;
+}
+
+/* Two semaphores that the ping-pong threads hand off through. */
+struct ping_pong 
+  {
+    struct semaphore ping, pong;
+  };
+
+static void pong_thread (void *pp_);
+
+/* Returns the cycles taken by SWITCH_CNT round trips between
+   this thread and another. */
+static uint64_t
+measure_switches (void) 
+{
+  struct ping_pong pp;
+  uint64_t start;
+  int i;
+
+  sema_init (&pp.ping, 0);
+  sema_init (&pp.pong, 0);
+  thread_create ("pong", PRI_DEFAULT, pong_thread, &pp);
+
+  start = timer_cycles ();
+  for (i = 0; i < SWITCH_CNT; i++) 
+    {
+      cpu_flush_tlb ();
+      touch_pages (SWITCH_PAGES);
+      sema_up (&pp.ping);
+      sema_down (&pp.pong);
+    }
+  return timer_cycles () - start;
+}
+
+static void
+pong_thread (void *pp_) 
+{
+  struct ping_pong *pp = pp_;
+  int i;
+
+  for (i = 0; i < SWITCH_CNT; i++) 
+    {
+      sema_down (&pp->ping);
+      cpu_flush_tlb ();
+      touch_pages (SWITCH_PAGES);
+      sema_up (&pp->pong);
+    }
+}
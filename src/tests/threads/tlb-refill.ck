@@ -0,0 +1,17 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+
+our ($test);
+
+my (@output) = read_text_file ("$test.output");
+common_checks ("run", @output);
+@output = get_core_output ("run", @output);
+
+pass if grep (/^\(tlb-refill\) Global pages not supported\.$/, @output);
+fail "Missing sweep cost.\n"
+  if !grep (/^\(tlb-refill\) Sweep after CR3 load: \d+ cycles global, \d+ cycles not global\.$/, @output);
+fail "Missing context switch cost.\n"
+  if !grep (/^\(tlb-refill\) Context switch: \d+ cycles global, \d+ cycles not global\.$/, @output);
+pass;
@@ -0,0 +1,85 @@
+/* Submits work items to a work queue, first half of them from
+   timer interrupt handlers and then half from a thread, and
+   checks that each one runs exactly once.  Some items sleep, which work
+   functions, unlike interrupt handlers, may do. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/interrupt.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "threads/workqueue.h"
+#include "devices/timer.h"
+
+#define TIMEOUT_CNT 50          /* Timeouts submitting items. */
+#define ITEMS_PER_TIMEOUT 10    /* Items submitted by each. */
+#define ITEM_CNT (2 * TIMEOUT_CNT * ITEMS_PER_TIMEOUT)
+
+static struct work_queue *wq;
+static int run_cnt[ITEM_CNT];           /* Times each item ran. */
+static int done_cnt;                    /* Items finished. */
+static struct semaphore all_done;       /* Upped by last item. */
+static struct timeout timeouts[TIMEOUT_CNT];
+
+static void submit_batch (void *first_);
+static void work_item (void *cnt_);
+
+void
+test_work_queue (void) 
+{
+  int i;
+
+  sema_init (&all_done, 0);
+  wq = work_queue_create ("test", 2, PRI_DEFAULT + 1);
+  if (wq == NULL)
+    fail ("work_queue_create failed");
+
+  /* Half the items from interrupt context. */
+  for (i = 0; i < TIMEOUT_CNT; i++)
+    timer_add (&timeouts[i], timer_ticks () + 1 + i, submit_batch,
+               &run_cnt[i * ITEMS_PER_TIMEOUT]);
+
+  timer_sleep (TIMEOUT_CNT + 1);
+
+  /* The other half from here, waiting for room if necessary. */
+  for (i = ITEM_CNT / 2; i < ITEM_CNT; i++)
+    while (!work_queue_submit (wq, work_item, &run_cnt[i]))
+      timer_sleep (1);
+
+  sema_down (&all_done);
+  for (i = 0; i < ITEM_CNT; i++)
+    if (run_cnt[i] != 1)
+      fail ("work item %d ran %d times", i, run_cnt[i]);
+  msg ("All %d work items ran exactly once.", ITEM_CNT);
+}
+
+/* Timeout function that submits ITEMS_PER_TIMEOUT items,
+   starting with the one counted by FIRST_. */
+static void
+submit_batch (void *first_) 
+{
+  int *first = first_;
+  int i;
+
+  for (i = 0; i < ITEMS_PER_TIMEOUT; i++)
+    if (!work_queue_submit (wq, work_item, first + i))
+      fail ("work queue overflowed in interrupt context");
+}
+
+/* Work function that counts a run of the item counted by CNT_. */
+static void
+work_item (void *cnt_) 
+{
+  int *cnt = cnt_;
+  enum intr_level old_level;
+
+  if ((cnt - run_cnt) % 50 == 0)
+    timer_sleep (1);
+
+  old_level = intr_disable ();
+  ++*cnt;
+  if (++done_cnt == ITEM_CNT)
+    sema_up (&all_done);
+  intr_set_level (old_level);
+}
@@ -0,0 +1,10 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(work-queue) begin
+(work-queue) All 1000 work items ran exactly once.
+(work-queue) end
+EOF
+pass;
@@ -0,0 +1,44 @@
+/* Sweeps 512 kB of initialized data, first in order and then in
+   a scrambled order, in a process that may have only 64 pages of
+   user memory.  The data does not fit, so its pages have to be
+   evicted and read back in over and over.  The data is only
+   read, so every page stays clean and can be evicted without
+   swap.
+
+   This is a benchmark for the frame table's clock eviction, in
+   the spirit of page-linear and page-shuffle.  The program does
+   not use the test library, which would make system calls to
+   print its output; the check computes the fault rate and
+   eviction throughput from the kernel's statistics instead. */
+
+#include <syscall.h>
+
+#define SIZE (512 * 1024)
+#define PAGE_SIZE 4096
+#define PAGE_CNT (SIZE / PAGE_SIZE)
+#define PASS_CNT 4
+
+static volatile char data[SIZE] = {[0] = 1};
+
+int
+main (void) 
+{
+  unsigned seed = 1;
+  int sum = 0;
+  int pass, i;
+
+  /* Linear passes. */
+  for (pass = 0; pass < PASS_CNT; pass++)
+    for (i = 0; i < PAGE_CNT; i++)
+      sum += data[i * PAGE_SIZE];
+
+  /* Scrambled passes. */
+  for (pass = 0; pass < PASS_CNT; pass++)
+    for (i = 0; i < PAGE_CNT; i++) 
+      {
+        seed = seed * 1103515245 + 12345;
+        sum += data[(seed >> 16) % PAGE_CNT * PAGE_SIZE];
+      }
+
+  exit (sum >= PASS_CNT ? 0 : 1);
+}
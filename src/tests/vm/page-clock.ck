@@ -0,0 +1,29 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+
+our ($test);
+
+my (@output) = read_text_file ("$test.output");
+common_checks ("run", @output);
+
+sub get_stat {
+    my ($re, $name) = @_;
+    my ($line) = grep (/$re/, @output);
+    fail "Missing $name.\n" if !defined $line;
+    my ($value) = $line =~ /$re/;
+    return $value;
+}
+
+my ($ticks) = get_stat (qr/^Timer: (\d+) ticks$/, "timer ticks");
+my ($faults) = get_stat (qr/^Exception: (\d+) page faults$/, "page faults");
+my ($evicted) = get_stat (qr/^Frame: \d+ frames in use, (\d+) evicted/,
+                          "eviction count");
+fail "No frames were evicted.\n" if $evicted == 0;
+
+$ticks = 1 if $ticks == 0;
+pass (sprintf ("%d page faults and %d evictions in %d ticks: "
+               . "%.1f faults and %.1f evictions per 100 ticks",
+               $faults, $evicted, $ticks,
+               $faults * 100 / $ticks, $evicted * 100 / $ticks));
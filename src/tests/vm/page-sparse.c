@@ -0,0 +1,21 @@
+/* Runs a program with a megabyte of initialized data, of which
+   it touches just the first and last bytes.  With demand paging,
+   only the pages that are touched should be read from the
+   executable, so starting it should take about as long as
+   starting a small program.
+
+   The program does not use the test library, which would make
+   system calls to print its output; it only exits, and the
+   check looks at the kernel's paging statistics instead. */
+
+#include <syscall.h>
+
+#define SIZE (1024 * 1024)
+
+static volatile char big[SIZE] = {[0] = 1, [SIZE - 1] = 2};
+
+int
+main (void) 
+{
+  exit (big[0] + big[SIZE - 1] == 3 ? 0 : 1);
+}
@@ -0,0 +1,16 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+
+our ($test);
+
+my (@output) = read_text_file ("$test.output");
+common_checks ("run", @output);
+
+my ($line) = grep (/^Paging: \d+ pages read from files/, @output);
+fail "Missing paging statistics.\n" if !defined $line;
+my ($read_cnt) = $line =~ /^Paging: (\d+) pages read from files/;
+fail "$read_cnt pages were read from the executable, "
+  . "but only a few were touched.\n" if $read_cnt >= 64;
+pass;
@@ -0,0 +1,30 @@
+/* Fills 512 kB of memory with a pattern and then checks it, in a
+   process that may have only 64 pages of user memory.  The
+   buffer does not fit, so its pages are modified, written to
+   swap, and read back.
+
+   The program does not use the test library, which would make
+   system calls to print its output; the check looks at the
+   kernel's swap statistics instead, and expects evicted pages
+   to have been written to swap in clusters. */
+
+#include <stddef.h>
+#include <syscall.h>
+
+#define SIZE (512 * 1024)
+#define PAGE_SIZE 4096
+
+static char buf[SIZE];
+
+int
+main (void) 
+{
+  size_t i;
+
+  for (i = 0; i < SIZE; i += PAGE_SIZE / 4)
+    buf[i] = i / PAGE_SIZE + 1;
+  for (i = 0; i < SIZE; i += PAGE_SIZE / 4)
+    if (buf[i] != (char) (i / PAGE_SIZE + 1))
+      exit (1);
+  exit (0);
+}
@@ -0,0 +1,28 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+
+our ($test);
+
+my (@output) = read_text_file ("$test.output");
+common_checks ("run", @output);
+
+my ($line) = grep (/^Swap: \d+ pages out in \d+ writes, \d+ pages in$/,
+                   @output);
+fail "Missing swap statistics.\n" if !defined $line;
+my ($out_cnt, $write_cnt, $in_cnt)
+  = $line =~ /^Swap: (\d+) pages out in (\d+) writes, (\d+) pages in$/;
+fail "No pages were swapped out.\n" if $out_cnt == 0;
+fail "No pages were swapped in.\n" if $in_cnt == 0;
+fail "$out_cnt pages were swapped out one write at a time.\n"
+  if $write_cnt >= $out_cnt;
+
+my ($latency) = grep (/^Swap: \d+ cycles per page out, \d+ cycles per page in$/,
+                      @output);
+fail "Missing swap latency.\n" if !defined $latency;
+chomp ($latency);
+pass (sprintf ("%d pages out in %d writes (%.1f pages per write), "
+               . "%d pages in", $out_cnt, $write_cnt,
+               $out_cnt / $write_cnt, $in_cnt),
+      $latency);
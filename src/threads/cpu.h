@@ -0,0 +1,60 @@
+#ifndef THREADS_CPU_H
+#define THREADS_CPU_H
+
+#include <stdint.h>
+
+/* Helpers for x86 processor features and control registers. */
+
+/* Processor features reported in EDX by CPUID leaf 1.  See
+   [IA32-v2a] "CPUID--CPU Identification". */
+#define CPUID_PSE (1u << 3)             /* 4 MB pages. */
+#define CPUID_PGE (1u << 13)            /* Global pages. */
+
+/* CR4 flags.  See [IA32-v3a] 2.5 "Control Registers". */
+#define CR4_PSE 0x00000010              /* Page Size Extensions. */
+#define CR4_PGE 0x00000080              /* Page Global Enable. */
+
+/* Returns the processor's CPUID_* feature flags. */
+static inline uint32_t
+cpu_features (void) 
+{
+  uint32_t eax = 1, ebx, ecx, edx;
+  asm volatile ("cpuid" : "+a" (eax), "=b" (ebx), "=c" (ecx), "=d" (edx));
+  return edx;
+}
+
+/* Returns the value of CR4. */
+static inline uint32_t
+cpu_get_cr4 (void) 
+{
+  uint32_t cr4;
+  asm volatile ("movl %%cr4, %0" : "=r" (cr4));
+  return cr4;
+}
+
+/* Sets CR4 to CR4.  Changing CR4_PGE flushes the whole TLB,
+   global entries included. */
+static inline void
+cpu_set_cr4 (uint32_t cr4) 
+{
+  asm volatile ("movl %0, %%cr4" : : "r" (cr4) : "memory");
+}
+
+/* Flushes the TLB entry, if any, for the page that contains
+   virtual address VADDR, even if it is global. */
+static inline void
+cpu_invlpg (const void *vaddr) 
+{
+  asm volatile ("invlpg (%0)" : : "r" (vaddr) : "memory");
+}
+
+/* Flushes every TLB entry that is not global by reloading CR3
+   with its current value, as switching address spaces does. */
+static inline void
+cpu_flush_tlb (void) 
+{
+  uint32_t cr3;
+  asm volatile ("movl %%cr3, %0; movl %0, %%cr3" : "=r" (cr3) : : "memory");
+}
+
+#endif /* threads/cpu.h */
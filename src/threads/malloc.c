@@ -5,8 +5,10 @@
 #include <stdint.h>
 #include <stdio.h>
 #include <string.h>
+#include "threads/interrupt.h"
 #include "threads/palloc.h"
 #include "threads/synch.h"
+#include "threads/thread.h"
 #include "threads/vaddr.h"
 
 /* A simple implementation of malloc().
@@ -23,16 +25,36 @@
    into blocks, all of which are added to the descriptor's free
    list.  Then we return one of the new blocks.
 
+   The blocks of a new arena are handed out one by one, in order,
+   as they are needed, rather than all being put on the free list
+   up front, so that creating an arena takes constant time.
+
    When we free a block, we add it to its descriptor's free list.
    But if the arena that the block was in now has no in-use
    blocks, we remove all of the arena's blocks from the free list
    and give the arena back to the page allocator.
 
+   Each thread also keeps a "magazine" of free blocks for each of
+   the smallest block sizes, which satisfies most allocations and
+   frees of those sizes without taking the descriptor's lock.
+   An empty magazine is refilled, and a full one drained, half a
+   magazine at a time, under a single acquisition of the lock.
+   Blocks in a magazine count as in use as far as their arenas
+   are concerned.  A thread's magazines are emptied when it
+   exits.  (On a multiprocessor, the magazines would better be
+   per-CPU, so that their number would not grow with the number
+   of threads.)
+
    We can't handle blocks bigger than 2 kB using this scheme,
    because they're too big to fit in a single page with a
    descriptor.  We handle those by allocating contiguous pages
    with the page allocator and sticking the allocation size at
-   the beginning of the allocated block's arena header. */
+   the beginning of the allocated block's arena header.
+
+   For statistics, each descriptor counts its arenas and the
+   blocks taken from them under its lock, and counts the blocks
+   actually in use by callers with interrupts disabled, since
+   the magazine fast path does not take the lock. */
 
 /* Descriptor. */
 struct desc
@@ -40,7 +62,17 @@ struct desc
     size_t block_size;          /* Size of each element in bytes. */
     size_t blocks_per_arena;    /* Number of blocks in an arena. */
     struct list free_list;      /* List of free blocks. */
+    struct arena *carving;      /* Arena with never-used blocks. */
     struct lock lock;           /* Lock. */
+
+    /* Statistics, protected by `lock'. */
+    size_t arena_cnt;           /* Arenas allocated. */
+    size_t used_cnt;            /* Blocks not in free list or carving. */
+
+    /* Statistics, protected by disabling interrupts. */
+    size_t live_cnt;            /* Blocks in use by callers. */
+    unsigned long long alloc_cnt;    /* Allocations ever made. */
+    unsigned long long wasted_bytes; /* Total bytes lost to rounding. */
   };
 
 /* Magic number for detecting arena corruption. */
@@ -52,6 +84,7 @@ struct arena
     unsigned magic;             /* Always set to ARENA_MAGIC. */
     struct desc *desc;          /* Owning descriptor, null for big block. */
     size_t free_cnt;            /* Free blocks; pages in big block. */
+    size_t carved_cnt;          /* Blocks ever handed out. */
   };
 
 /* Free block. */
@@ -61,11 +94,25 @@ struct block
   };
 
 /* Our set of descriptors. */
-static struct desc descs[10];   /* Descriptors. */
+static struct desc descs[MALLOC_CLASS_MAX]; /* Descriptors. */
 static size_t desc_cnt;         /* Number of descriptors. */
 
+/* Statistics for big blocks, protected by disabling
+   interrupts. */
+static size_t big_live_cnt;     /* Blocks in use. */
+static size_t big_page_cnt;     /* Pages in those blocks. */
+static unsigned long long big_alloc_cnt;    /* Allocations ever made. */
+static unsigned long long big_wasted_bytes; /* Bytes lost to rounding. */
+
 static struct arena *block_to_arena (struct block *);
 static struct block *arena_to_block (struct arena *, size_t idx);
+static struct block *desc_get_block (struct desc *);
+static void desc_put_block (struct desc *, struct block *);
+static struct magazine *desc_magazine (struct desc *);
+static void magazine_refill (struct desc *, struct magazine *);
+static void magazine_drain (struct desc *, struct magazine *, unsigned cnt);
+static void count_alloc (struct desc *, size_t size);
+static void count_free (struct desc *, size_t page_cnt);
 
 /* Initializes the malloc() descriptors. */
 void
@@ -80,7 +127,26 @@ malloc_init (void)
       d->block_size = block_size;
       d->blocks_per_arena = (PGSIZE - sizeof (struct arena)) / block_size;
       list_init (&d->free_list);
+      d->carving = NULL;
       lock_init (&d->lock);
+      d->arena_cnt = d->used_cnt = d->live_cnt = 0;
+      d->alloc_cnt = d->wasted_bytes = 0;
+    }
+  ASSERT (desc_cnt >= MAGAZINE_CLASS_CNT);
+}
+
+/* Returns the blocks in the running thread's magazines to their
+   descriptors.  Called by thread_exit(). */
+void
+malloc_thread_exit (void) 
+{
+  size_t i;
+
+  for (i = 0; i < MAGAZINE_CLASS_CNT; i++) 
+    {
+      struct magazine *m = &thread_current ()->magazines[i];
+      if (m->cnt > 0)
+        magazine_drain (&descs[i], m, m->cnt);
     }
 }
 
@@ -92,6 +158,7 @@ malloc (size_t size)
   struct desc *d;
   struct block *b;
   struct arena *a;
+  struct magazine *m;
 
   /* A null pointer satisfies a request for 0 bytes. */
   if (size == 0)
@@ -116,40 +183,27 @@ malloc (size_t size)
       a->magic = ARENA_MAGIC;
       a->desc = NULL;
       a->free_cnt = page_cnt;
+      count_alloc (NULL, size);
       return a + 1;
     }
 
-  lock_acquire (&d->lock);
-
-  /* If the free list is empty, create a new arena. */
-  if (list_empty (&d->free_list))
+  /* Take a block from our magazine if we have one. */
+  m = desc_magazine (d);
+  if (m != NULL) 
     {
-      size_t i;
-
-      /* Allocate a page. */
-      a = palloc_get_page (0);
-      if (a == NULL) 
-        {
-          lock_release (&d->lock);
-          return NULL; 
-        }
-
-      /* Initialize arena and add its blocks to the free list. */
-      a->magic = ARENA_MAGIC;
-      a->desc = d;
-      a->free_cnt = d->blocks_per_arena;
-      for (i = 0; i < d->blocks_per_arena; i++) 
-        {
-          struct block *b = arena_to_block (a, i);
-          list_push_back (&d->free_list, &b->free_elem);
-        }
+      if (m->cnt == 0)
+        magazine_refill (d, m);
+      b = m->cnt > 0 ? m->blocks[--m->cnt] : NULL;
+    }
+  else 
+    {
+      lock_acquire (&d->lock);
+      b = desc_get_block (d);
+      lock_release (&d->lock);
     }
 
-  /* Get a block from free list and return it. */
-  b = list_entry (list_pop_front (&d->free_list), struct block, free_elem);
-  a = block_to_arena (b);
-  a->free_cnt--;
-  lock_release (&d->lock);
+  if (b != NULL)
+    count_alloc (d, size);
   return b;
 }
 
@@ -227,42 +281,264 @@ free (void *p)
       if (d != NULL) 
         {
           /* It's a normal block.  We handle it here. */
+          struct magazine *m;
 
 #ifndef NDEBUG
           /* Clear the block to help detect use-after-free bugs. */
           memset (b, 0xcc, d->block_size);
 #endif
-  
-          lock_acquire (&d->lock);
 
-          /* Add block to free list. */
-          list_push_front (&d->free_list, &b->free_elem);
+          count_free (d, 0);
 
-          /* If the arena is now entirely unused, free it. */
-          if (++a->free_cnt >= d->blocks_per_arena) 
+          /* Put it in our magazine if we have one, making room
+             first if it is full. */
+          m = desc_magazine (d);
+          if (m != NULL) 
             {
-              size_t i;
-
-              ASSERT (a->free_cnt == d->blocks_per_arena);
-              for (i = 0; i < d->blocks_per_arena; i++) 
-                {
-                  struct block *b = arena_to_block (a, i);
-                  list_remove (&b->free_elem);
-                }
-              palloc_free_page (a);
+              if (m->cnt >= MAGAZINE_SIZE)
+                magazine_drain (d, m, MAGAZINE_SIZE / 2);
+              m->blocks[m->cnt++] = b;
+              return;
             }
-
+  
+          lock_acquire (&d->lock);
+          desc_put_block (d, b);
           lock_release (&d->lock);
         }
       else
         {
           /* It's a big block.  Free its pages. */
+          count_free (NULL, a->free_cnt);
           palloc_free_multiple (a, a->free_cnt);
           return;
         }
     }
 }
 
+/* Removes and returns a free block from descriptor D, taking it
+   from the free list, or failing that from the never-used blocks
+   of the arena being carved up, or failing that from a new
+   arena.  Returns a null pointer if memory is not available.
+   D's lock must be held. */
+static struct block *
+desc_get_block (struct desc *d) 
+{
+  struct block *b;
+  struct arena *a;
+
+  ASSERT (lock_held_by_current_thread (&d->lock));
+
+  if (!list_empty (&d->free_list)) 
+    {
+      b = list_entry (list_pop_front (&d->free_list), struct block,
+                      free_elem);
+      a = block_to_arena (b);
+    }
+  else 
+    {
+      /* If there is no arena to carve, create one. */
+      a = d->carving;
+      if (a == NULL) 
+        {
+          a = palloc_get_page (0);
+          if (a == NULL)
+            return NULL;
+          a->magic = ARENA_MAGIC;
+          a->desc = d;
+          a->free_cnt = d->blocks_per_arena;
+          a->carved_cnt = 0;
+          d->carving = a;
+          d->arena_cnt++;
+        }
+
+      b = arena_to_block (a, a->carved_cnt++);
+      if (a->carved_cnt >= d->blocks_per_arena)
+        d->carving = NULL;
+    }
+
+  a->free_cnt--;
+  d->used_cnt++;
+  return b;
+}
+
+/* Returns free block B to descriptor D.  If that leaves B's arena
+   entirely unused, frees the arena.  D's lock must be held. */
+static void
+desc_put_block (struct desc *d, struct block *b) 
+{
+  struct arena *a = block_to_arena (b);
+
+  ASSERT (lock_held_by_current_thread (&d->lock));
+
+  /* Add block to free list. */
+  list_push_front (&d->free_list, &b->free_elem);
+  d->used_cnt--;
+
+  /* If the arena is now entirely unused, free it.  Only the
+     blocks carved from it so far are on the free list. */
+  if (++a->free_cnt >= d->blocks_per_arena) 
+    {
+      size_t i;
+
+      ASSERT (a->free_cnt == d->blocks_per_arena);
+      for (i = 0; i < a->carved_cnt; i++) 
+        {
+          struct block *b = arena_to_block (a, i);
+          list_remove (&b->free_elem);
+        }
+      if (d->carving == a)
+        d->carving = NULL;
+      d->arena_cnt--;
+      palloc_free_page (a);
+    }
+}
+
+/* Returns the running thread's magazine for descriptor D, or a
+   null pointer if blocks of D's size are not cached. */
+static struct magazine *
+desc_magazine (struct desc *d) 
+{
+  size_t idx = d - descs;
+
+  return idx < MAGAZINE_CLASS_CNT ? &thread_current ()->magazines[idx] : NULL;
+}
+
+/* Fills empty magazine M with half a magazine of blocks from
+   descriptor D, or as many as are available. */
+static void
+magazine_refill (struct desc *d, struct magazine *m) 
+{
+  ASSERT (m->cnt == 0);
+
+  lock_acquire (&d->lock);
+  while (m->cnt < MAGAZINE_SIZE / 2) 
+    {
+      struct block *b = desc_get_block (d);
+      if (b == NULL)
+        break;
+      m->blocks[m->cnt++] = b;
+    }
+  lock_release (&d->lock);
+}
+
+/* Returns the CNT least recently freed blocks in magazine M to
+   descriptor D. */
+static void
+magazine_drain (struct desc *d, struct magazine *m, unsigned cnt) 
+{
+  unsigned i;
+
+  ASSERT (cnt <= m->cnt);
+
+  lock_acquire (&d->lock);
+  for (i = 0; i < cnt; i++)
+    desc_put_block (d, m->blocks[i]);
+  lock_release (&d->lock);
+
+  m->cnt -= cnt;
+  memmove (m->blocks, m->blocks + cnt, m->cnt * sizeof *m->blocks);
+}
+
+/* Counts an allocation of a SIZE-byte block from descriptor D,
+   or of a big block if D is null. */
+static void
+count_alloc (struct desc *d, size_t size) 
+{
+  enum intr_level old_level = intr_disable ();
+
+  if (d != NULL) 
+    {
+      d->live_cnt++;
+      d->alloc_cnt++;
+      d->wasted_bytes += d->block_size - size;
+    }
+  else 
+    {
+      size_t page_cnt = DIV_ROUND_UP (size + sizeof (struct arena), PGSIZE);
+
+      big_live_cnt++;
+      big_page_cnt += page_cnt;
+      big_alloc_cnt++;
+      big_wasted_bytes += page_cnt * PGSIZE - sizeof (struct arena) - size;
+    }
+  intr_set_level (old_level);
+}
+
+/* Counts the freeing of a block from descriptor D, or of a big
+   block of PAGE_CNT pages if D is null. */
+static void
+count_free (struct desc *d, size_t page_cnt) 
+{
+  enum intr_level old_level = intr_disable ();
+
+  if (d != NULL)
+    d->live_cnt--;
+  else 
+    {
+      big_live_cnt--;
+      big_page_cnt -= page_cnt;
+    }
+  intr_set_level (old_level);
+}
+
+/* Fills in *S with statistics for malloc(). */
+void
+malloc_get_stats (struct malloc_stats *s) 
+{
+  enum intr_level old_level;
+  size_t i;
+
+  s->class_cnt = desc_cnt;
+  for (i = 0; i < desc_cnt; i++) 
+    {
+      struct desc *d = &descs[i];
+      struct malloc_class_stats *c = &s->classes[i];
+
+      lock_acquire (&d->lock);
+      old_level = intr_disable ();
+      c->block_size = d->block_size;
+      c->arena_cnt = d->arena_cnt;
+      c->live_cnt = d->live_cnt;
+      c->cached_cnt = d->used_cnt - d->live_cnt;
+      c->alloc_cnt = d->alloc_cnt;
+      c->wasted_bytes = d->wasted_bytes;
+      intr_set_level (old_level);
+      lock_release (&d->lock);
+    }
+
+  old_level = intr_disable ();
+  s->big_live_cnt = big_live_cnt;
+  s->big_page_cnt = big_page_cnt;
+  s->big_alloc_cnt = big_alloc_cnt;
+  s->big_wasted_bytes = big_wasted_bytes;
+  intr_set_level (old_level);
+}
+
+/* Prints malloc() statistics. */
+void
+malloc_print_stats (void) 
+{
+  static struct malloc_stats s;
+  size_t i;
+
+  malloc_get_stats (&s);
+  for (i = 0; i < s.class_cnt; i++) 
+    {
+      struct malloc_class_stats *c = &s.classes[i];
+      if (c->alloc_cnt == 0)
+        continue;
+      printf ("Malloc %zu-byte blocks: %zu arenas, %zu live, %zu cached, "
+              "%llu allocations, %llu bytes lost to rounding\n",
+              c->block_size, c->arena_cnt, c->live_cnt, c->cached_cnt,
+              c->alloc_cnt, c->wasted_bytes);
+    }
+  if (s.big_alloc_cnt > 0)
+    printf ("Malloc big blocks: %zu live in %zu pages, "
+            "%llu allocations, %llu bytes lost to rounding\n",
+            s.big_live_cnt, s.big_page_cnt, s.big_alloc_cnt,
+            s.big_wasted_bytes);
+}
+
 /* Returns the arena that block B is inside. */
 static struct arena *
 block_to_arena (struct block *b)
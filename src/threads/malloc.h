@@ -4,7 +4,44 @@
 #include <debug.h>
 #include <stddef.h>
 
+/* A thread's cache of free blocks of one size.  See malloc.c. */
+#define MAGAZINE_SIZE 8         /* Blocks in a full magazine. */
+#define MAGAZINE_CLASS_CNT 5    /* Sizes cached, from 16 to 256 bytes. */
+struct magazine 
+  {
+    unsigned cnt;               /* Number of blocks. */
+    void *blocks[MAGAZINE_SIZE]; /* Free blocks, most recent last. */
+  };
+
+/* Statistics for one malloc() size class. */
+struct malloc_class_stats 
+  {
+    size_t block_size;                  /* Bytes per block. */
+    size_t arena_cnt;                   /* Arenas allocated. */
+    size_t live_cnt;                    /* Blocks in use by callers. */
+    size_t cached_cnt;                  /* Free blocks in magazines. */
+    unsigned long long alloc_cnt;       /* Allocations ever made. */
+    unsigned long long wasted_bytes;    /* Total bytes lost to rounding. */
+  };
+
+/* Statistics for malloc() as a whole. */
+#define MALLOC_CLASS_MAX 10             /* Maximum number of size classes. */
+struct malloc_stats 
+  {
+    size_t class_cnt;                   /* Number of size classes. */
+    struct malloc_class_stats classes[MALLOC_CLASS_MAX];
+
+    /* Blocks too big for any size class. */
+    size_t big_live_cnt;                /* Blocks in use. */
+    size_t big_page_cnt;                /* Pages in those blocks. */
+    unsigned long long big_alloc_cnt;   /* Allocations ever made. */
+    unsigned long long big_wasted_bytes; /* Total bytes lost to rounding. */
+  };
+
 void malloc_init (void);
+void malloc_thread_exit (void);
+void malloc_get_stats (struct malloc_stats *);
+void malloc_print_stats (void);
 void *malloc (size_t) __attribute__ ((malloc));
 void *calloc (size_t, size_t) __attribute__ ((malloc));
 void *realloc (void *, size_t);
@@ -1,48 +1,142 @@
 #include "threads/palloc.h"
-#include <bitmap.h>
 #include <debug.h>
 #include <inttypes.h>
+#include <list.h>
 #include <round.h>
 #include <stddef.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <string.h>
 #include "threads/init.h"
+#include "threads/interrupt.h"
 #include "threads/loader.h"
 #include "threads/synch.h"
 #include "threads/vaddr.h"
+#include "threads/workqueue.h"
 
 /* Page allocator.  Hands out memory in page-size (or
    page-multiple) chunks.  See malloc.h for an allocator that
    hands out smaller chunks.
 
-   System memory is divided into two "pools" called the kernel
-   and user pools.  The user pool is for user (virtual) memory
-   pages, the kernel pool for everything else.  The idea here is
-   that the kernel needs to have memory for its own operations
-   even if user processes are swapping like mad.
+   All free memory forms a single pool, but each page allocated
+   belongs to one of two "classes": user pages, for user
+   (virtual) memory, and kernel pages, for everything else.  Each
+   class has a reservation, a number of pages that the other
+   class may not take, so that the kernel has memory for its own
+   operations even if user processes are swapping like mad, and
+   vice versa.  Beyond their reservations, the classes share
+   whatever is free, so that a kernel busy caching files can
+   borrow pages that user processes are not using, and the
+   reverse.  The user class is also limited to user_page_limit
+   pages, if that is set.
 
-   By default, half of system RAM is given to the kernel pool and
-   half to the user pool.  That should be huge overkill for the
-   kernel pool, but that's just fine for demonstration purposes. */
+   By default, a quarter of memory is reserved for each class,
+   and the remaining half is shared.
 
-/* A memory pool. */
+   The pool is managed as a binary buddy system.  Free memory is
+   kept in blocks of 2**N pages, for "order" N, each aligned to a
+   multiple of its size relative to the pool's base, on one free
+   list per order.  An allocation of PAGE_CNT pages takes a block
+   of the least sufficient order, splitting a larger block if
+   necessary, and gives the pages beyond PAGE_CNT back.  Freeing
+   a block merges it with its "buddy", the other half of the
+   block of the next order up, for as long as the buddy is free
+   too.  Allocating or freeing a single page thus takes constant
+   time if a free page is on hand, and any allocation or free
+   takes time logarithmic in the size of the pool.
+
+   Zeroing a page takes far longer than allocating it, and many
+   callers, such as the page fault handler, want zeroed pages on
+   paths where latency matters.  So the idle thread, when it has
+   nothing better to do, zeroes free pages in advance, up to
+   ZERO_TARGET of them, and single-page PAL_ZERO allocations are
+   served from these pages first.  The idle thread must never
+   block, so it only ever tries to acquire the pool's lock.  The
+   pre-zeroed pages count as allocated as far as the buddy system
+   is concerned, but as free for everything else.
+
+   Other modules that hold pages they could give up, such as
+   caches, register "reclaimers" with palloc_add_reclaimer().
+   When free pages drop below a low watermark, the reclaimers are
+   run in the background, on the system work queue, until free
+   pages are back above a high watermark.  An allocation that
+   would otherwise fail runs them directly and tries again. */
+
+/* Number of block orders.  The largest block, of order
+   ORDER_CNT - 1, is bigger than any pool can be. */
+#define ORDER_CNT 20
+
+/* Values in the pool's `states' array for a page that does not
+   begin a free block.  Otherwise, the value is the order of the
+   free block that the page begins. */
+#define NOT_FREE UINT8_MAX              /* Free or in transit. */
+#define KERNEL_PAGE (UINT8_MAX - 1)     /* Allocated as kernel page. */
+#define USER_PAGE (UINT8_MAX - 2)       /* Allocated as user page. */
+
+/* Pre-zeroed pages to keep, and the number of free pages below
+   which the idle thread stops zeroing more. */
+#define ZERO_TARGET 32
+#define ZERO_MIN_FREE (4 * ZERO_TARGET)
+
+/* Maximum number of reclaimers. */
+#define RECLAIMER_MAX 8
+
+/* A class of allocated pages. */
+struct page_class
+  {
+    const char *name;                   /* Name, for statistics. */
+    uint8_t state;                      /* KERNEL_PAGE or USER_PAGE. */
+    size_t used_cnt;                    /* Pages allocated. */
+    size_t reserve;                     /* Pages the other class can't take. */
+    size_t limit;                       /* Most pages that may be used. */
+
+    /* Statistics. */
+    size_t peak_used;                   /* Most pages ever in use. */
+    unsigned long long alloc_cnt;       /* Successful allocations. */
+    unsigned long long zeroed_hit_cnt;  /* Served by pre-zeroed pages. */
+    unsigned long long fail_cnt;        /* Failed allocations. */
+  };
+
+/* The memory pool.  All members are protected by `lock'. */
 struct pool
   {
     struct lock lock;                   /* Mutual exclusion. */
-    struct bitmap *used_map;            /* Bitmap of free pages. */
+    uint8_t *states;                    /* Per-page state or free order. */
+    struct list free_lists[ORDER_CNT];  /* Free blocks, by order. */
+    size_t page_cnt;                    /* Number of pages in pool. */
+    size_t free_cnt;                    /* Pages in free blocks. */
     uint8_t *base;                      /* Base of pool. */
+    struct list zeroed;                 /* Pre-zeroed pages. */
+    size_t zeroed_cnt;                  /* Number of pages in `zeroed'. */
+    size_t low_watermark;               /* Start reclaiming below this. */
+    size_t high_watermark;              /* Stop reclaiming above this. */
+    bool reclaim_queued;                /* Background reclaim pending? */
   };
 
-/* Two pools: one for kernel data, one for user pages. */
-struct pool kernel_pool, user_pool;
+static struct pool pool;
+static struct page_class kernel_class, user_class;
 
 /* Maximum number of pages to put in user pool. */
 size_t user_page_limit = SIZE_MAX;
 
-static void init_pool (struct pool *, void *base, size_t page_cnt,
-                       const char *name);
-static bool page_from_pool (const struct pool *, void *page);
+/* Registered reclaimers. */
+static palloc_reclaim_func *reclaimers[RECLAIMER_MAX];
+static int reclaimer_cnt;
+
+static void init_class (struct page_class *, const char *name,
+                        uint8_t state, size_t reserve, size_t limit);
+static void *alloc_class_pages (struct page_class *, size_t page_cnt,
+                                bool zero, bool *zeroed);
+static bool class_may_allocate (const struct page_class *, size_t page_cnt);
+static size_t alloc_pages (struct pool *, size_t page_cnt);
+static void free_pages (struct pool *, size_t page_idx, size_t page_cnt);
+static void free_block (struct pool *, size_t page_idx, int order);
+static size_t free_total (const struct pool *);
+static bool start_reclaim (void);
+static size_t reclaim_pages (void);
+static void background_reclaim (void *aux);
+static bool prezero_page (void);
+static size_t release_zeroed_pages (struct pool *);
 
 /* Initializes the page allocator. */
 void
@@ -55,47 +149,94 @@ palloc_init (void)
   /* Free memory. */
   uint8_t *free_start = pg_round_up (&_end);
   uint8_t *free_end = ptov (ram_pages * PGSIZE);
-  size_t free_pages = (free_end - free_start) / PGSIZE;
-  size_t user_pages = free_pages / 2;
-  size_t kernel_pages;
-  if (user_pages > user_page_limit)
-    user_pages = user_page_limit;
-  kernel_pages = free_pages - user_pages;
+  size_t page_cnt = (free_end - free_start) / PGSIZE;
+
+  /* We'll put the pool's per-page states at its base.
+     Calculate the space needed for them
+     and subtract it from the pool's size. */
+  size_t meta_pages = DIV_ROUND_UP (page_cnt, PGSIZE);
+  size_t user_limit, user_reserve;
+  int i;
 
-  /* Give half of memory to kernel, half to user. */
-  init_pool (&kernel_pool, free_start, kernel_pages, "kernel pool");
-  init_pool (&user_pool, free_start + kernel_pages * PGSIZE,
-             user_pages, "user pool");
+  if (meta_pages > page_cnt)
+    PANIC ("Not enough memory for page states.");
+  page_cnt -= meta_pages;
+
+  /* Initialize the pool, with every page free. */
+  lock_init (&pool.lock);
+  pool.states = free_start;
+  memset (pool.states, NOT_FREE, page_cnt);
+  for (i = 0; i < ORDER_CNT; i++)
+    list_init (&pool.free_lists[i]);
+  pool.page_cnt = page_cnt;
+  pool.free_cnt = 0;
+  pool.base = free_start + meta_pages * PGSIZE;
+  list_init (&pool.zeroed);
+  pool.zeroed_cnt = 0;
+  pool.low_watermark = page_cnt / 32;
+  pool.high_watermark = page_cnt / 16;
+  pool.reclaim_queued = false;
+  free_pages (&pool, 0, page_cnt);
+
+  /* Set up the classes. */
+  user_limit = user_page_limit < page_cnt ? user_page_limit : page_cnt;
+  user_reserve = page_cnt / 4 < user_limit ? page_cnt / 4 : user_limit;
+  init_class (&kernel_class, "Kernel", KERNEL_PAGE, page_cnt / 4, page_cnt);
+  init_class (&user_class, "User", USER_PAGE, user_reserve, user_limit);
+
+  printf ("%zu pages available, %zu reserved for kernel, "
+          "%zu reserved for user.\n",
+          page_cnt, kernel_class.reserve, user_class.reserve);
 }
 
 /* Obtains and returns a group of PAGE_CNT contiguous free pages.
-   If PAL_USER is set, the pages are obtained from the user pool,
-   otherwise from the kernel pool.  If PAL_ZERO is set in FLAGS,
-   then the pages are filled with zeros.  If too few pages are
-   available, returns a null pointer, unless PAL_ASSERT is set in
-   FLAGS, in which case the kernel panics. */
+   If PAL_USER is set, the pages are user pages, otherwise kernel
+   pages.  If PAL_ZERO is set in FLAGS, then the pages are filled
+   with zeros.  If too few pages are available, returns a null
+   pointer, unless PAL_ASSERT is set in FLAGS, in which case the
+   kernel panics.
+
+   Before giving up, runs the reclaimers and tries again. */
 void *
 palloc_get_multiple (enum palloc_flags flags, size_t page_cnt)
 {
-  struct pool *pool = flags & PAL_USER ? &user_pool : &kernel_pool;
+  struct page_class *c = flags & PAL_USER ? &user_class : &kernel_class;
+  bool zero = (flags & PAL_ZERO) != 0;
+  bool zeroed, reclaim;
   void *pages;
-  size_t page_idx;
 
   if (page_cnt == 0)
     return NULL;
 
-  lock_acquire (&pool->lock);
-  page_idx = bitmap_scan_and_flip (pool->used_map, 0, page_cnt, false);
-  lock_release (&pool->lock);
+  lock_acquire (&pool.lock);
+  pages = alloc_class_pages (c, page_cnt, zero, &zeroed);
+  reclaim = start_reclaim ();
+  lock_release (&pool.lock);
 
-  if (page_idx != BITMAP_ERROR)
-    pages = pool->base + PGSIZE * page_idx;
-  else
-    pages = NULL;
+  if (pages == NULL && reclaim_pages () > 0)
+    {
+      lock_acquire (&pool.lock);
+      pages = alloc_class_pages (c, page_cnt, zero, &zeroed);
+      lock_release (&pool.lock);
+    }
+  if (pages == NULL)
+    {
+      lock_acquire (&pool.lock);
+      c->fail_cnt++;
+      lock_release (&pool.lock);
+    }
+
+  /* Reclaim in the background if we are running low. */
+  if (reclaim && !work_submit (background_reclaim, NULL))
+    {
+      lock_acquire (&pool.lock);
+      pool.reclaim_queued = false;
+      lock_release (&pool.lock);
+    }
 
   if (pages != NULL) 
     {
-      if (flags & PAL_ZERO)
+      if (zero && !zeroed)
         memset (pages, 0, PGSIZE * page_cnt);
     }
   else 
@@ -109,11 +250,11 @@ palloc_get_multiple (enum palloc_flags flags, size_t page_cnt)
 
 /* Obtains a single free page and returns its kernel virtual
    address.
-   If PAL_USER is set, the page is obtained from the user pool,
-   otherwise from the kernel pool.  If PAL_ZERO is set in FLAGS,
-   then the page is filled with zeros.  If no pages are
-   available, returns a null pointer, unless PAL_ASSERT is set in
-   FLAGS, in which case the kernel panics. */
+   If PAL_USER is set, the page is a user page, otherwise a
+   kernel page.  If PAL_ZERO is set in FLAGS, then the page is
+   filled with zeros.  If no pages are available, returns a null
+   pointer, unless PAL_ASSERT is set in FLAGS, in which case the
+   kernel panics. */
 void *
 palloc_get_page (enum palloc_flags flags) 
 {
@@ -124,28 +265,36 @@ palloc_get_page (enum palloc_flags flags)
 void
 palloc_free_multiple (void *pages, size_t page_cnt) 
 {
-  struct pool *pool;
-  size_t page_idx;
+  struct page_class *c;
+  size_t page_idx, i;
 
   ASSERT (pg_ofs (pages) == 0);
   if (pages == NULL || page_cnt == 0)
     return;
 
-  if (page_from_pool (&kernel_pool, pages))
-    pool = &kernel_pool;
-  else if (page_from_pool (&user_pool, pages))
-    pool = &user_pool;
-  else
-    NOT_REACHED ();
-
-  page_idx = pg_no (pages) - pg_no (pool->base);
+  ASSERT ((uint8_t *) pages >= pool.base);
+  page_idx = pg_no (pages) - pg_no (pool.base);
+  ASSERT (page_idx + page_cnt <= pool.page_cnt);
 
 #ifndef NDEBUG
   memset (pages, 0xcc, PGSIZE * page_cnt);
 #endif
 
-  ASSERT (bitmap_all (pool->used_map, page_idx, page_cnt));
-  bitmap_set_multiple (pool->used_map, page_idx, page_cnt, false);
+  lock_acquire (&pool.lock);
+  if (pool.states[page_idx] == USER_PAGE)
+    c = &user_class;
+  else if (pool.states[page_idx] == KERNEL_PAGE)
+    c = &kernel_class;
+  else 
+    NOT_REACHED ();
+  for (i = 0; i < page_cnt; i++)
+    {
+      ASSERT (pool.states[page_idx + i] == c->state);
+      pool.states[page_idx + i] = NOT_FREE;
+    }
+  c->used_cnt -= page_cnt;
+  free_pages (&pool, page_idx, page_cnt);
+  lock_release (&pool.lock);
 }
 
 /* Frees the page at PAGE. */
@@ -155,35 +304,382 @@ palloc_free_page (void *page)
   palloc_free_multiple (page, 1);
 }
 
-/* Initializes pool P as starting at START and ending at END,
-   naming it NAME for debugging purposes. */
+/* Registers FUNC to be called to give back pages when memory
+   runs low.  FUNC must return the number of pages it freed.  It
+   is called in thread context, without the pool's lock held, and
+   may itself free pages but must not allocate them. */
+void
+palloc_add_reclaimer (palloc_reclaim_func *func)
+{
+  ASSERT (func != NULL);
+  ASSERT (reclaimer_cnt < RECLAIMER_MAX);
+
+  reclaimers[reclaimer_cnt++] = func;
+}
+
+/* Fills in *S with statistics for user pages if PAL_USER is set
+   in FLAGS, otherwise for kernel pages. */
+void
+palloc_get_stats (enum palloc_flags flags, struct palloc_stats *s) 
+{
+  struct page_class *c = flags & PAL_USER ? &user_class : &kernel_class;
+  int order;
+
+  lock_acquire (&pool.lock);
+  s->page_cnt = pool.page_cnt;
+  s->free_cnt = free_total (&pool);
+  s->zeroed_cnt = pool.zeroed_cnt;
+  s->largest_free = pool.zeroed_cnt > 0;
+  for (order = ORDER_CNT - 1; order >= 0; order--)
+    if (!list_empty (&pool.free_lists[order]))
+      {
+        s->largest_free = (size_t) 1 << order;
+        break;
+      }
+  s->used_cnt = c->used_cnt;
+  s->reserve = c->reserve;
+  s->limit = c->limit;
+  s->peak_used = c->peak_used;
+  s->alloc_cnt = c->alloc_cnt;
+  s->zeroed_hit_cnt = c->zeroed_hit_cnt;
+  s->fail_cnt = c->fail_cnt;
+  lock_release (&pool.lock);
+}
+
+/* Prints page allocator statistics. */
+void
+palloc_print_stats (void) 
+{
+  struct palloc_stats s;
+  int i;
+
+  palloc_get_stats (0, &s);
+  printf ("Page pool: %zu of %zu pages free (%zu pre-zeroed), "
+          "largest free block %zu pages\n",
+          s.free_cnt, s.page_cnt, s.zeroed_cnt, s.largest_free);
+  for (i = 0; i < 2; i++) 
+    {
+      struct page_class *c = i == 0 ? &kernel_class : &user_class;
+
+      palloc_get_stats (i == 0 ? 0 : PAL_USER, &s);
+      printf ("%s pages: %zu used (peak %zu), %zu reserved, %zu limit, "
+              "%llu allocations (%llu pre-zeroed), %llu failed\n",
+              c->name, s.used_cnt, s.peak_used, s.reserve, s.limit,
+              s.alloc_cnt, s.zeroed_hit_cnt, s.fail_cnt);
+    }
+}
+
+/* Zeroes free pages in advance for later PAL_ZERO allocations,
+   until there are enough or another thread becomes ready to run.
+   Called only by the idle thread.  Never blocks. */
+void
+palloc_idle (void) 
+{
+  while (prezero_page ())
+    continue;
+}
+
+/* Initializes page class C with the given NAME, page STATE,
+   RESERVE, and LIMIT. */
 static void
-init_pool (struct pool *p, void *base, size_t page_cnt, const char *name) 
+init_class (struct page_class *c, const char *name, uint8_t state,
+            size_t reserve, size_t limit)
 {
-  /* We'll put the pool's used_map at its base.
-     Calculate the space needed for the bitmap
-     and subtract it from the pool's size. */
-  size_t bm_pages = DIV_ROUND_UP (bitmap_buf_size (page_cnt), PGSIZE);
-  if (bm_pages > page_cnt)
-    PANIC ("Not enough memory in %s for bitmap.", name);
-  page_cnt -= bm_pages;
+  c->name = name;
+  c->state = state;
+  c->used_cnt = 0;
+  c->reserve = reserve;
+  c->limit = limit;
+  c->peak_used = 0;
+  c->alloc_cnt = c->zeroed_hit_cnt = c->fail_cnt = 0;
+}
+
+/* Allocates PAGE_CNT contiguous pages for class C and returns the
+   first, or returns a null pointer if C may not have that many
+   more pages or no free block is big enough.  If ZERO is true,
+   the caller wants the pages zeroed; *ZEROED is set to true if
+   they already are.  The pool's lock must be held. */
+static void *
+alloc_class_pages (struct page_class *c, size_t page_cnt, bool zero,
+                   bool *zeroed)
+{
+  size_t page_idx, i;
+
+  ASSERT (lock_held_by_current_thread (&pool.lock));
+
+  *zeroed = false;
+  if (!class_may_allocate (c, page_cnt))
+    return NULL;
+
+  if (zero && page_cnt == 1 && !list_empty (&pool.zeroed))
+    {
+      /* The list element was the only nonzero data in the page. */
+      struct list_elem *e = list_pop_front (&pool.zeroed);
+      pool.zeroed_cnt--;
+      memset (e, 0, sizeof *e);
+      page_idx = ((uint8_t *) e - pool.base) / PGSIZE;
+      c->zeroed_hit_cnt++;
+      *zeroed = true;
+    }
+  else 
+    {
+      page_idx = alloc_pages (&pool, page_cnt);
+      if (page_idx == SIZE_MAX && release_zeroed_pages (&pool) > 0)
+        page_idx = alloc_pages (&pool, page_cnt);
+      if (page_idx == SIZE_MAX)
+        return NULL;
+    }
+
+  for (i = 0; i < page_cnt; i++)
+    pool.states[page_idx + i] = c->state;
+  c->alloc_cnt++;
+  c->used_cnt += page_cnt;
+  if (c->used_cnt > c->peak_used)
+    c->peak_used = c->used_cnt;
+  return pool.base + PGSIZE * page_idx;
+}
 
-  printf ("%zu pages available in %s.\n", page_cnt, name);
+/* Returns true if class C may allocate PAGE_CNT more pages
+   without exceeding its limit or eating into the other class's
+   reservation.  The pool's lock must be held. */
+static bool
+class_may_allocate (const struct page_class *c, size_t page_cnt)
+{
+  const struct page_class *other = c == &user_class ? &kernel_class
+                                                     : &user_class;
+  size_t held_back = (other->used_cnt < other->reserve
+                      ? other->reserve - other->used_cnt : 0);
+
+  return (c->used_cnt + page_cnt <= c->limit
+          && free_total (&pool) >= page_cnt + held_back);
+}
+
+/* Returns the number of free pages in POOL, including
+   pre-zeroed pages.  The pool's lock must be held, except by the
+   idle thread, which may read a stale value. */
+static size_t
+free_total (const struct pool *p)
+{
+  return p->free_cnt + p->zeroed_cnt;
+}
+
+/* Returns the page in POOL with index PAGE_IDX, as a list
+   element.  A free block is linked into its free list through
+   its first page. */
+static struct list_elem *
+block_elem (const struct pool *pool, size_t page_idx) 
+{
+  return (struct list_elem *) (pool->base + PGSIZE * page_idx);
+}
+
+/* Returns the index in POOL of the block whose first page is
+   E. */
+static size_t
+block_idx (const struct pool *pool, struct list_elem *e) 
+{
+  return ((uint8_t *) e - pool->base) / PGSIZE;
+}
+
+/* Allocates PAGE_CNT contiguous pages from POOL and returns the
+   index of the first, or SIZE_MAX if POOL has no free block big
+   enough.  POOL's lock must be held. */
+static size_t
+alloc_pages (struct pool *pool, size_t page_cnt) 
+{
+  size_t page_idx;
+  int order, i;
+
+  ASSERT (lock_held_by_current_thread (&pool->lock));
+
+  /* Find the least order big enough, then the least order at
+     least that big with a free block. */
+  for (order = 0; ((size_t) 1 << order) < page_cnt; order++)
+    if (order + 1 >= ORDER_CNT)
+      return SIZE_MAX;
+  for (i = order; i < ORDER_CNT; i++)
+    if (!list_empty (&pool->free_lists[i]))
+      break;
+  if (i >= ORDER_CNT)
+    return SIZE_MAX;
+
+  page_idx = block_idx (pool, list_pop_front (&pool->free_lists[i]));
+  pool->states[page_idx] = NOT_FREE;
+  pool->free_cnt -= (size_t) 1 << i;
+
+  /* Split the block until it has the order we want, freeing the
+     upper half each time. */
+  while (i > order) 
+    {
+      i--;
+      free_block (pool, page_idx + ((size_t) 1 << i), i);
+      pool->free_cnt += (size_t) 1 << i;
+    }
+
+  /* Give back the pages beyond the ones requested. */
+  free_pages (pool, page_idx + page_cnt, ((size_t) 1 << order) - page_cnt);
+
+  return page_idx;
+}
+
+/* Frees the PAGE_CNT pages in POOL starting at index PAGE_IDX,
+   as a series of blocks each as big as its alignment allows.
+   POOL's lock must be held, except during initialization. */
+static void
+free_pages (struct pool *pool, size_t page_idx, size_t page_cnt) 
+{
+  while (page_cnt > 0) 
+    {
+      int order = 0;
+
+      while (order + 1 < ORDER_CNT
+             && page_idx % ((size_t) 2 << order) == 0
+             && ((size_t) 2 << order) <= page_cnt)
+        order++;
+
+      free_block (pool, page_idx, order);
+      pool->free_cnt += (size_t) 1 << order;
+      page_idx += (size_t) 1 << order;
+      page_cnt -= (size_t) 1 << order;
+    }
+}
+
+/* Frees the block of 2**ORDER pages in POOL starting at index
+   PAGE_IDX, which must be aligned to its size, merging it with
+   its buddy for as long as the buddy is free.  Does not adjust
+   POOL's count of free pages. */
+static void
+free_block (struct pool *pool, size_t page_idx, int order) 
+{
+  ASSERT (page_idx % ((size_t) 1 << order) == 0);
+  ASSERT (pool->states[page_idx] == NOT_FREE);
+
+  for (; order + 1 < ORDER_CNT; order++) 
+    {
+      size_t buddy = page_idx ^ ((size_t) 1 << order);
 
-  /* Initialize the pool. */
-  lock_init (&p->lock);
-  p->used_map = bitmap_create_in_buf (page_cnt, base, bm_pages * PGSIZE);
-  p->base = base + bm_pages * PGSIZE;
+      if (buddy >= pool->page_cnt || pool->states[buddy] != order)
+        break;
+
+      list_remove (block_elem (pool, buddy));
+      pool->states[buddy] = NOT_FREE;
+      if (buddy < page_idx)
+        page_idx = buddy;
+    }
+
+  pool->states[page_idx] = order;
+  list_push_front (&pool->free_lists[order], block_elem (pool, page_idx));
 }
 
-/* Returns true if PAGE was allocated from POOL,
-   false otherwise. */
+/* Returns true, and marks background reclaim as queued, if free
+   pages are below the low watermark and background reclaim is
+   not already queued.  The caller must then queue it.  The
+   pool's lock must be held. */
 static bool
-page_from_pool (const struct pool *pool, void *page) 
+start_reclaim (void) 
+{
+  ASSERT (lock_held_by_current_thread (&pool.lock));
+
+  if (free_total (&pool) >= pool.low_watermark || reclaimer_cnt == 0
+      || pool.reclaim_queued)
+    return false;
+  pool.reclaim_queued = true;
+  return true;
+}
+
+/* Runs every reclaimer and returns the total number of pages
+   they freed. */
+static size_t
+reclaim_pages (void)
 {
-  size_t page_no = pg_no (page);
-  size_t start_page = pg_no (pool->base);
-  size_t end_page = start_page + bitmap_size (pool->used_map);
+  size_t cnt = 0;
+  int i;
+
+  for (i = 0; i < reclaimer_cnt; i++)
+    cnt += reclaimers[i] ();
+  return cnt;
+}
+
+/* Work function that runs the reclaimers until free pages are
+   above the high watermark or the reclaimers make no
+   progress. */
+static void
+background_reclaim (void *aux UNUSED)
+{
+  for (;;)
+    {
+      bool done;
+
+      lock_acquire (&pool.lock);
+      done = free_total (&pool) >= pool.high_watermark;
+      lock_release (&pool.lock);
+      if (done || reclaim_pages () == 0)
+        break;
+    }
+
+  lock_acquire (&pool.lock);
+  pool.reclaim_queued = false;
+  lock_release (&pool.lock);
+}
+
+/* Takes a free page, zeroes it, and adds it to the pre-zeroed
+   pages.  Returns false if there are already enough pre-zeroed
+   pages, if the pool is short of free pages, or if its lock is
+   held.  Called only by the idle thread.  Never blocks. */
+static bool
+prezero_page (void)
+{
+  static void *page;            /* Page taken but not yet added. */
+  enum intr_level old_level;
+  bool added = false;
+
+  /* Keep interrupts off while we hold the lock, so that we are
+     never preempted holding it: a thread that blocked on the
+     lock would donate its priority to the idle thread, which
+     is never in a run queue. */
+  if (page == NULL)
+    {
+      size_t page_idx = SIZE_MAX;
+
+      old_level = intr_disable ();
+      if (pool.zeroed_cnt < ZERO_TARGET && pool.free_cnt > ZERO_MIN_FREE
+          && lock_try_acquire (&pool.lock))
+        {
+          page_idx = alloc_pages (&pool, 1);
+          lock_release (&pool.lock);
+        }
+      intr_set_level (old_level);
+      if (page_idx == SIZE_MAX)
+        return false;
+
+      page = pool.base + PGSIZE * page_idx;
+      memset (page, 0, PGSIZE);
+    }
+
+  old_level = intr_disable ();
+  if (lock_try_acquire (&pool.lock))
+    {
+      list_push_front (&pool.zeroed, page);
+      pool.zeroed_cnt++;
+      lock_release (&pool.lock);
+      page = NULL;
+      added = true;
+    }
+  intr_set_level (old_level);
+  return added;
+}
+
+/* Returns all of POOL's pre-zeroed pages to its free lists and
+   returns the number of pages returned.  POOL's lock must be
+   held. */
+static size_t
+release_zeroed_pages (struct pool *pool) 
+{
+  size_t cnt = pool->zeroed_cnt;
+
+  ASSERT (lock_held_by_current_thread (&pool->lock));
 
-  return page_no >= start_page && page_no < end_page;
+  while (!list_empty (&pool->zeroed))
+    free_pages (pool, block_idx (pool, list_pop_front (&pool->zeroed)), 1);
+  pool->zeroed_cnt = 0;
+  return cnt;
 }
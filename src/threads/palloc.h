@@ -14,10 +14,38 @@ enum palloc_flags
 /* Maximum number of pages to put in user pool. */
 extern size_t user_page_limit;
 
+/* Statistics for the pool and for the kernel or user pages in
+   it. */
+struct palloc_stats 
+  {
+    /* The pool as a whole. */
+    size_t page_cnt;                    /* Pages in pool. */
+    size_t free_cnt;                    /* Free pages, with pre-zeroed. */
+    size_t zeroed_cnt;                  /* Pre-zeroed free pages. */
+    size_t largest_free;                /* Pages in largest free block. */
+
+    /* Kernel or user pages. */
+    size_t used_cnt;                    /* Pages in use. */
+    size_t reserve;                     /* Pages reserved. */
+    size_t limit;                       /* Most pages that may be used. */
+    size_t peak_used;                   /* Most pages ever in use. */
+    unsigned long long alloc_cnt;       /* Successful allocations. */
+    unsigned long long zeroed_hit_cnt;  /* Served by pre-zeroed pages. */
+    unsigned long long fail_cnt;        /* Failed allocations. */
+  };
+
+/* Gives back pages when memory runs low, returning the number
+   of pages freed.  See palloc_add_reclaimer(). */
+typedef size_t palloc_reclaim_func (void);
+
 void palloc_init (void);
 void *palloc_get_page (enum palloc_flags);
 void *palloc_get_multiple (enum palloc_flags, size_t page_cnt);
 void palloc_free_page (void *);
 void palloc_free_multiple (void *, size_t page_cnt);
+void palloc_idle (void);
+void palloc_add_reclaimer (palloc_reclaim_func *);
+void palloc_get_stats (enum palloc_flags, struct palloc_stats *);
+void palloc_print_stats (void);
 
 #endif /* threads/palloc.h */
@@ -0,0 +1,309 @@
+#include "threads/slab.h"
+#include <debug.h>
+#include <list.h>
+#include <round.h>
+#include <stdint.h>
+#include <stdio.h>
+#include "threads/interrupt.h"
+#include "threads/malloc.h"
+#include "threads/palloc.h"
+#include "threads/synch.h"
+#include "threads/vaddr.h"
+
+/* Slab allocator for fixed-size objects.
+
+   malloc() rounds every request up to a power of 2, so an object
+   whose size is just over a power of 2 wastes nearly half its
+   block, and all objects of similar size contend for one lock.
+   A slab cache instead hands out objects of exactly one size,
+   packed into page-size "slabs", with a lock of its own.
+
+   Each slab begins with a header that records which of its
+   objects are free as a stack of object indexes, so that a free
+   object's contents are left alone: an object freed in its
+   constructed state is still constructed when it is next
+   allocated, and the cache's constructor runs only when a slab
+   is created.
+
+   A cache keeps its slabs on three lists: partly used slabs,
+   from which it allocates first, full slabs, and empty slabs.
+   At most SLAB_EMPTY_MAX empty slabs are kept, so that an object
+   allocated and freed over and over does not create and destroy
+   a slab each time.  slab_reclaim() returns the rest to the page
+   allocator, which calls it when it runs low on pages. */
+
+#define SLAB_EMPTY_MAX 1        /* Empty slabs kept per cache. */
+#define SLAB_ALIGN 4            /* Alignment of objects. */
+
+/* Magic number for detecting slab corruption. */
+#define SLAB_MAGIC 0x51ab51ab
+
+/* A slab cache. */
+struct kmem_cache 
+  {
+    struct list_elem elem;      /* Element in cache_list. */
+    const char *name;           /* Name, for statistics. */
+    size_t obj_size;            /* Size of each object, rounded up. */
+    size_t objs_per_slab;       /* Number of objects in a slab. */
+    size_t obj_ofs;             /* Offset of first object in slab. */
+    kmem_ctor *ctor;            /* Constructor, or null. */
+    struct lock lock;           /* Protects the members below. */
+    struct list partial;        /* Slabs with some objects in use. */
+    struct list full;           /* Slabs with every object in use. */
+    struct list empty;          /* Slabs with no objects in use. */
+    size_t empty_cnt;           /* Number of slabs in `empty'. */
+
+    /* Statistics. */
+    size_t slab_cnt;            /* Slabs allocated. */
+    size_t in_use;              /* Objects allocated. */
+    size_t peak_in_use;         /* Most objects ever allocated. */
+  };
+
+/* Slab header, at the beginning of each slab's page. */
+struct slab 
+  {
+    unsigned magic;             /* Always set to SLAB_MAGIC. */
+    struct kmem_cache *cache;   /* Owning cache. */
+    struct list_elem elem;      /* Element in one of cache's lists. */
+    uint16_t free_cnt;          /* Number of free objects. */
+    uint16_t free[];            /* Indexes of free objects. */
+  };
+
+/* All caches, for reclaim and statistics. */
+static struct list cache_list;
+
+static size_t slab_reclaim (void);
+static struct slab *slab_create (struct kmem_cache *);
+static void *slab_obj (struct kmem_cache *, struct slab *, size_t idx);
+
+/* Initializes the slab allocator. */
+void
+slab_init (void) 
+{
+  list_init (&cache_list);
+  palloc_add_reclaimer (slab_reclaim);
+}
+
+/* Creates and returns a cache of SIZE-byte objects named NAME.
+   If CTOR is nonnull, it is called on each object when its slab
+   is created.  Returns a null pointer if memory for the cache
+   cannot be allocated.  A cache lasts until the system shuts
+   down. */
+struct kmem_cache *
+kmem_cache_create (const char *name, size_t size, kmem_ctor *ctor) 
+{
+  struct kmem_cache *c;
+  enum intr_level old_level;
+  size_t n;
+
+  ASSERT (name != NULL);
+  ASSERT (size > 0);
+
+  c = malloc (sizeof *c);
+  if (c == NULL)
+    return NULL;
+  c->name = name;
+  c->obj_size = ROUND_UP (size, SLAB_ALIGN);
+  c->ctor = ctor;
+
+  /* Fit as many objects as possible, with their free-stack
+     entries, in a page after the slab header. */
+  n = (PGSIZE - sizeof (struct slab)) / (c->obj_size + sizeof (uint16_t));
+  while (n > 0
+         && ROUND_UP (sizeof (struct slab) + n * sizeof (uint16_t),
+                      SLAB_ALIGN) + n * c->obj_size > PGSIZE)
+    n--;
+  if (n == 0)
+    PANIC ("%s: %zu-byte objects are too big for a slab", name, size);
+  c->objs_per_slab = n;
+  c->obj_ofs = ROUND_UP (sizeof (struct slab) + n * sizeof (uint16_t),
+                         SLAB_ALIGN);
+
+  lock_init (&c->lock);
+  list_init (&c->partial);
+  list_init (&c->full);
+  list_init (&c->empty);
+  c->empty_cnt = 0;
+  c->slab_cnt = c->in_use = c->peak_in_use = 0;
+
+  old_level = intr_disable ();
+  list_push_back (&cache_list, &c->elem);
+  intr_set_level (old_level);
+
+  return c;
+}
+
+/* Allocates and returns an object from cache C, or a null
+   pointer if memory is not available. */
+void *
+kmem_cache_alloc (struct kmem_cache *c) 
+{
+  struct slab *s;
+  void *obj;
+
+  ASSERT (c != NULL);
+
+  lock_acquire (&c->lock);
+  while (list_empty (&c->partial) && list_empty (&c->empty)) 
+    {
+      /* Create a slab without holding the lock, because the page
+         allocator may call back into slab_reclaim(). */
+      lock_release (&c->lock);
+      s = slab_create (c);
+      if (s == NULL)
+        return NULL;
+      lock_acquire (&c->lock);
+      list_push_back (&c->empty, &s->elem);
+      c->empty_cnt++;
+      c->slab_cnt++;
+    }
+
+  if (!list_empty (&c->partial))
+    s = list_entry (list_front (&c->partial), struct slab, elem);
+  else 
+    {
+      s = list_entry (list_pop_front (&c->empty), struct slab, elem);
+      list_push_front (&c->partial, &s->elem);
+      c->empty_cnt--;
+    }
+
+  obj = slab_obj (c, s, s->free[--s->free_cnt]);
+  if (s->free_cnt == 0) 
+    {
+      list_remove (&s->elem);
+      list_push_front (&c->full, &s->elem);
+    }
+  if (++c->in_use > c->peak_in_use)
+    c->peak_in_use = c->in_use;
+  lock_release (&c->lock);
+
+  return obj;
+}
+
+/* Frees OBJ, which must have been allocated from cache C.  If
+   OBJ is a null pointer, does nothing. */
+void
+kmem_cache_free (struct kmem_cache *c, void *obj) 
+{
+  struct slab *s;
+  size_t idx;
+
+  ASSERT (c != NULL);
+  if (obj == NULL)
+    return;
+
+  s = pg_round_down (obj);
+  ASSERT (s->magic == SLAB_MAGIC);
+  ASSERT (s->cache == c);
+  idx = ((uint8_t *) obj - (uint8_t *) s - c->obj_ofs) / c->obj_size;
+  ASSERT (slab_obj (c, s, idx) == obj);
+
+  lock_acquire (&c->lock);
+  ASSERT (s->free_cnt < c->objs_per_slab);
+  s->free[s->free_cnt++] = idx;
+  c->in_use--;
+  if (s->free_cnt == c->objs_per_slab) 
+    {
+      /* Now empty: keep it, or give it back. */
+      list_remove (&s->elem);
+      if (c->empty_cnt < SLAB_EMPTY_MAX) 
+        {
+          list_push_front (&c->empty, &s->elem);
+          c->empty_cnt++;
+        }
+      else 
+        {
+          c->slab_cnt--;
+          palloc_free_page (s);
+        }
+    }
+  else if (s->free_cnt == 1) 
+    {
+      /* No longer full. */
+      list_remove (&s->elem);
+      list_push_front (&c->partial, &s->elem);
+    }
+  lock_release (&c->lock);
+}
+
+/* Returns every empty slab in every cache to the page allocator,
+   skipping caches that are in use, and returns the number of
+   pages freed.  Registered with the page allocator as a
+   reclaimer. */
+static size_t
+slab_reclaim (void) 
+{
+  struct list_elem *e;
+  size_t cnt = 0;
+
+  for (e = list_begin (&cache_list); e != list_end (&cache_list);
+       e = list_next (e)) 
+    {
+      struct kmem_cache *c = list_entry (e, struct kmem_cache, elem);
+
+      if (!lock_try_acquire (&c->lock))
+        continue;
+      while (!list_empty (&c->empty)) 
+        {
+          struct slab *s = list_entry (list_pop_front (&c->empty),
+                                       struct slab, elem);
+          c->empty_cnt--;
+          c->slab_cnt--;
+          palloc_free_page (s);
+          cnt++;
+        }
+      lock_release (&c->lock);
+    }
+  return cnt;
+}
+
+/* Prints statistics for every slab cache. */
+void
+slab_print_stats (void) 
+{
+  struct list_elem *e;
+
+  for (e = list_begin (&cache_list); e != list_end (&cache_list);
+       e = list_next (e)) 
+    {
+      struct kmem_cache *c = list_entry (e, struct kmem_cache, elem);
+      size_t capacity = c->slab_cnt * c->objs_per_slab;
+
+      printf ("Slab %s: %zu of %zu objects in use (peak %zu), "
+              "%zu slabs, %zu%% utilization\n",
+              c->name, c->in_use, capacity, c->peak_in_use, c->slab_cnt,
+              capacity > 0 ? c->in_use * c->obj_size * 100
+                             / (c->slab_cnt * PGSIZE) : 0);
+    }
+}
+
+/* Allocates a page for a new slab in cache C, constructs its
+   objects, and returns it, or returns a null pointer if no page
+   is available. */
+static struct slab *
+slab_create (struct kmem_cache *c) 
+{
+  struct slab *s = palloc_get_page (0);
+  size_t i;
+
+  if (s == NULL)
+    return NULL;
+
+  s->magic = SLAB_MAGIC;
+  s->cache = c;
+  s->free_cnt = c->objs_per_slab;
+  for (i = 0; i < c->objs_per_slab; i++) 
+    {
+      s->free[i] = c->objs_per_slab - 1 - i;
+      if (c->ctor != NULL)
+        c->ctor (slab_obj (c, s, i));
+    }
+  return s;
+}
+
+/* Returns object IDX in slab S of cache C. */
+static void *
+slab_obj (struct kmem_cache *c, struct slab *s, size_t idx) 
+{
+  return (uint8_t *) s + c->obj_ofs + idx * c->obj_size;
+}
@@ -31,6 +31,55 @@
 #include <string.h>
 #include "threads/interrupt.h"
 #include "threads/thread.h"
+#ifdef LOCKSTAT
+#include "devices/timer.h"
+#endif
+
+/* Semaphore and condition variable waiters are kept in heaps
+   ordered by priority, so that the highest-priority waiter can be
+   woken in O(log n) time.  Waiters of equal priority are woken in
+   the order they began to wait, by sequence number. */
+static int64_t next_wait_seq;
+
+/* A thread that must wait for a lock donates its priority to the
+   lock's holder, to the holder of the lock that holder is waiting
+   for, and so on, up to this many locks deep. */
+#define DONATION_DEPTH 8
+
+static void donate_priority (struct thread *);
+
+#ifdef LOCKSTAT
+/* Lock contention statistics, compiled in only if LOCKSTAT is
+   defined, e.g. by building with "make LOCKSTAT=1".  Locks are
+   grouped by name, and the statistics for each name are kept in
+   a fixed table, since lock_init() may run before malloc() can.
+   Names beyond the table's capacity share its last entry. */
+#define LOCKSTAT_CNT 64
+
+struct lockstat 
+  {
+    const char *name;           /* Lock name. */
+    long long acquire_cnt;      /* Number of acquisitions. */
+    long long contended_cnt;    /* Number that had to wait. */
+    int64_t wait_ticks;         /* Total ticks spent waiting. */
+    int64_t max_wait_ticks;     /* Longest wait. */
+    int64_t hold_ticks;         /* Total ticks held. */
+    int64_t max_hold_ticks;     /* Longest hold. */
+  };
+
+static struct lockstat lockstats[LOCKSTAT_CNT];
+static size_t lockstat_cnt;
+
+static struct lockstat *lockstat_lookup (const char *name);
+static void lockstat_acquired (struct lock *, bool contended,
+                               int64_t wait_start);
+static void lockstat_released (struct lock *);
+#endif
+
+static bool sema_waiter_less (const struct heap_elem *,
+                              const struct heap_elem *, void *aux);
+static bool cond_waiter_less (const struct heap_elem *,
+                              const struct heap_elem *, void *aux);
 
 /* Initializes semaphore SEMA to VALUE.  A semaphore is a
    nonnegative integer along with two atomic operators for
@@ -47,7 +96,7 @@ sema_init (struct semaphore *sema, unsigned value)
   ASSERT (sema != NULL);
 
   sema->value = value;
-  list_init (&sema->waiters);
+  heap_init (&sema->waiters, sema_waiter_less, NULL);
 }
 
 /* Down or "P" operation on a semaphore.  Waits for SEMA's value
@@ -61,6 +110,7 @@ sema_init (struct semaphore *sema, unsigned value)
 void
 sema_down (struct semaphore *sema) 
 {
+  struct thread *curr = thread_current ();
   enum intr_level old_level;
 
   ASSERT (sema != NULL);
@@ -69,9 +119,12 @@ sema_down (struct semaphore *sema)
   old_level = intr_disable ();
   while (sema->value == 0) 
     {
-      list_push_back (&sema->waiters, &thread_current ()->elem);
+      curr->wait_sema = sema;
+      curr->wait_seq = next_wait_seq++;
+      heap_insert (&sema->waiters, &curr->heap_elem);
       thread_block ();
     }
+  curr->wait_sema = NULL;
   sema->value--;
   intr_set_level (old_level);
 }
@@ -103,22 +156,43 @@ sema_try_down (struct semaphore *sema)
 }
 
 /* Up or "V" operation on a semaphore.  Increments SEMA's value
-   and wakes up one thread of those waiting for SEMA, if any.
+   and wakes up the highest-priority thread of those waiting for
+   SEMA, if any.  If that thread should preempt the running
+   thread, yields to it, unless interrupts were disabled.
 
    This function may be called from an interrupt handler. */
 void
 sema_up (struct semaphore *sema) 
 {
   enum intr_level old_level;
+  bool yield = false;
 
   ASSERT (sema != NULL);
 
   old_level = intr_disable ();
-  if (!list_empty (&sema->waiters)) 
-    thread_unblock (list_entry (list_pop_front (&sema->waiters),
-                                struct thread, elem));
+  if (!heap_empty (&sema->waiters)) 
+    {
+      struct thread *t = heap_entry (heap_pop_min (&sema->waiters),
+                                     struct thread, heap_elem);
+      t->wait_sema = NULL;
+      thread_unblock (t);
+
+      /* An interrupt handler that wakes a more urgent thread,
+         e.g. a disk completion, lets it run as soon as the
+         handler returns. */
+      if (intr_context ())
+        {
+          if (thread_preempts (t))
+            intr_yield_on_return ();
+        }
+      else
+        yield = old_level == INTR_ON && thread_preempts (t);
+    }
   sema->value++;
   intr_set_level (old_level);
+
+  if (yield)
+    thread_yield ();
 }
 
 static void sema_test_helper (void *sema_);
@@ -174,17 +248,24 @@ sema_test_helper (void *sema_)
    onerous, it's a good sign that a semaphore should be used,
    instead of a lock. */
 void
-lock_init (struct lock *lock)
+lock_init_named (struct lock *lock, const char *name UNUSED)
 {
   ASSERT (lock != NULL);
+  ASSERT (name != NULL);
 
   lock->holder = NULL;
   sema_init (&lock->semaphore, 1);
+#ifdef LOCKSTAT
+  lock->stat = lockstat_lookup (name);
+  lock->acquire_tick = 0;
+#endif
 }
 
 /* Acquires LOCK, sleeping until it becomes available if
    necessary.  The lock must not already be held by the current
-   thread.
+   thread.  While we wait, the holder runs with at least our
+   priority, except under the multi-level feedback queue
+   scheduler.
 
    This function may sleep, so it must not be called within an
    interrupt handler.  This function may be called with
@@ -193,12 +274,34 @@ lock_init (struct lock *lock)
 void
 lock_acquire (struct lock *lock)
 {
+  struct thread *curr = thread_current ();
+  enum intr_level old_level;
+#ifdef LOCKSTAT
+  int64_t wait_start = timer_ticks ();
+  bool contended;
+#endif
+
   ASSERT (lock != NULL);
   ASSERT (!intr_context ());
   ASSERT (!lock_held_by_current_thread (lock));
 
+  old_level = intr_disable ();
+#ifdef LOCKSTAT
+  contended = lock->semaphore.value == 0;
+#endif
+  if (lock->holder != NULL && !thread_mlfqs) 
+    {
+      curr->waiting_lock = lock;
+      donate_priority (curr);
+    }
   sema_down (&lock->semaphore);
-  lock->holder = thread_current ();
+  curr->waiting_lock = NULL;
+  lock->holder = curr;
+  list_push_back (&curr->held_locks, &lock->elem);
+#ifdef LOCKSTAT
+  lockstat_acquired (lock, contended, wait_start);
+#endif
+  intr_set_level (old_level);
 }
 
 /* Tries to acquires LOCK and returns true if successful or false
@@ -210,19 +313,30 @@ lock_acquire (struct lock *lock)
 bool
 lock_try_acquire (struct lock *lock)
 {
+  enum intr_level old_level;
   bool success;
 
   ASSERT (lock != NULL);
   ASSERT (!lock_held_by_current_thread (lock));
 
+  old_level = intr_disable ();
   success = sema_try_down (&lock->semaphore);
-  if (success)
-    lock->holder = thread_current ();
+  if (success) 
+    {
+      lock->holder = thread_current ();
+      list_push_back (&lock->holder->held_locks, &lock->elem);
+#ifdef LOCKSTAT
+      lockstat_acquired (lock, false, timer_ticks ());
+#endif
+    }
+  intr_set_level (old_level);
   return success;
 }
 
 /* Releases LOCK, which must be owned by the current thread.
-   This is lock_release function.
+   Gives up any priority donated through LOCK, and yields if a
+   thread that should preempt us, such as the waiter on LOCK that
+   was donating, is now ready.
 
    An interrupt handler cannot acquire a lock, so it does not
    make sense to try to release a lock within an interrupt
@@ -230,11 +344,28 @@ lock_try_acquire (struct lock *lock)
 void
 lock_release (struct lock *lock) 
 {
+  struct thread *curr = thread_current ();
+  enum intr_level old_level;
+
   ASSERT (lock != NULL);
   ASSERT (lock_held_by_current_thread (lock));
 
+  /* Drop our priority and wake the next holder atomically, so
+     that no thread of intermediate priority can run in
+     between. */
+  old_level = intr_disable ();
+#ifdef LOCKSTAT
+  lockstat_released (lock);
+#endif
   lock->holder = NULL;
+  list_remove (&lock->elem);
+  if (!thread_mlfqs)
+    thread_update_priority (curr);
   sema_up (&lock->semaphore);
+  intr_set_level (old_level);
+
+  if (old_level == INTR_ON)
+    thread_yield_if_outranked ();
 }
 
 /* Returns true if the current thread holds LOCK, false
@@ -248,11 +379,105 @@ lock_held_by_current_thread (const struct lock *lock)
   return lock->holder == thread_current ();
 }
 
-/* One semaphore in a list. */
+#ifdef LOCKSTAT
+/* Prints contention statistics for every lock name that has
+   been acquired at least once.  May be called at any time. */
+void
+lock_print_stats (void) 
+{
+  size_t i;
+
+  for (i = 0; i < lockstat_cnt; i++) 
+    {
+      struct lockstat s;
+      enum intr_level old_level = intr_disable ();
+      s = lockstats[i];
+      intr_set_level (old_level);
+
+      if (s.acquire_cnt > 0)
+        printf ("Lock %s: %lld acquired, %lld contended, "
+                "%lld ticks waited (%lld max), "
+                "%lld ticks held (%lld max)\n",
+                s.name, s.acquire_cnt, s.contended_cnt,
+                s.wait_ticks, s.max_wait_ticks,
+                s.hold_ticks, s.max_hold_ticks);
+    }
+}
+
+/* Returns the statistics entry for locks named NAME, creating it
+   if necessary. */
+static struct lockstat *
+lockstat_lookup (const char *name) 
+{
+  enum intr_level old_level = intr_disable ();
+  struct lockstat *s;
+  size_t i;
+
+  for (i = 0; i < lockstat_cnt; i++)
+    if (!strcmp (lockstats[i].name, name))
+      break;
+  if (i == lockstat_cnt) 
+    {
+      if (lockstat_cnt < LOCKSTAT_CNT)
+        lockstats[lockstat_cnt++].name = name;
+      else
+        {
+          i = LOCKSTAT_CNT - 1;
+          lockstats[i].name = "(other)";
+        }
+    }
+  s = &lockstats[i];
+  intr_set_level (old_level);
+
+  return s;
+}
+
+/* Records that the current thread acquired LOCK, having started
+   to wait for it at WAIT_START, and had to wait if CONTENDED is
+   true.  Interrupts must be off. */
+static void
+lockstat_acquired (struct lock *lock, bool contended, int64_t wait_start) 
+{
+  struct lockstat *s = lock->stat;
+  int64_t now = timer_ticks ();
+
+  ASSERT (intr_get_level () == INTR_OFF);
+
+  s->acquire_cnt++;
+  if (contended) 
+    {
+      int64_t wait = now - wait_start;
+      s->contended_cnt++;
+      s->wait_ticks += wait;
+      if (wait > s->max_wait_ticks)
+        s->max_wait_ticks = wait;
+    }
+  lock->acquire_tick = now;
+}
+
+/* Records that the current thread is releasing LOCK.  Interrupts
+   must be off. */
+static void
+lockstat_released (struct lock *lock) 
+{
+  struct lockstat *s = lock->stat;
+  int64_t hold = timer_ticks () - lock->acquire_tick;
+
+  ASSERT (intr_get_level () == INTR_OFF);
+
+  s->hold_ticks += hold;
+  if (hold > s->max_hold_ticks)
+    s->max_hold_ticks = hold;
+}
+#endif /* LOCKSTAT */
+
+/* One semaphore in a condition variable's heap of waiters. */
 struct semaphore_elem 
   {
-    struct list_elem elem;              /* List element. */
+    struct heap_elem elem;              /* Heap element. */
     struct semaphore semaphore;         /* This semaphore. */
+    struct thread *thread;              /* Thread waiting on it. */
+    int64_t seq;                        /* Orders equal-priority waiters. */
   };
 
 /* Initializes condition variable COND.  A condition variable
@@ -263,7 +488,7 @@ cond_init (struct condition *cond)
 {
   ASSERT (cond != NULL);
 
-  list_init (&cond->waiters);
+  heap_init (&cond->waiters, cond_waiter_less, NULL);
 }
 
 /* Atomically releases LOCK and waits for COND to be signaled by
@@ -289,7 +514,9 @@ cond_init (struct condition *cond)
 void
 cond_wait (struct condition *cond, struct lock *lock) 
 {
+  struct thread *curr = thread_current ();
   struct semaphore_elem waiter;
+  enum intr_level old_level;
 
   ASSERT (cond != NULL);
   ASSERT (lock != NULL);
@@ -297,15 +524,26 @@ cond_wait (struct condition *cond, struct lock *lock)
   ASSERT (lock_held_by_current_thread (lock));
   
   sema_init (&waiter.semaphore, 0);
-  list_push_back (&cond->waiters, &waiter.elem);
+  waiter.thread = curr;
+
+  /* Our priority may change while we wait, and so our position
+     in COND's waiters with it; see synch_reorder_waiter(). */
+  old_level = intr_disable ();
+  waiter.seq = next_wait_seq++;
+  curr->wait_cond = cond;
+  curr->wait_sema = &waiter.semaphore;
+  heap_insert (&cond->waiters, &waiter.elem);
+  intr_set_level (old_level);
+
   lock_release (lock);
   sema_down (&waiter.semaphore);
   lock_acquire (lock);
 }
 
 /* If any threads are waiting on COND (protected by LOCK), then
-   this function signals one of them to wake up from its wait.
-   LOCK must be held before calling this function.
+   this function signals the highest-priority one of them to wake
+   up from its wait.  LOCK must be held before calling this
+   function.
 
    An interrupt handler cannot acquire a lock, so it does not
    make sense to try to signal a condition variable within an
@@ -318,23 +556,297 @@ cond_signal (struct condition *cond, struct lock *lock UNUSED)
   ASSERT (!intr_context ());
   ASSERT (lock_held_by_current_thread (lock));
 
-  if (!list_empty (&cond->waiters)) 
-    sema_up (&list_entry (list_pop_front (&cond->waiters),
-                          struct semaphore_elem, elem)->semaphore);
+  if (!heap_empty (&cond->waiters)) 
+    {
+      struct semaphore_elem *waiter;
+      enum intr_level old_level;
+
+      old_level = intr_disable ();
+      waiter = heap_entry (heap_pop_min (&cond->waiters),
+                           struct semaphore_elem, elem);
+      waiter->thread->wait_cond = NULL;
+      intr_set_level (old_level);
+
+      sema_up (&waiter->semaphore);
+    }
 }
 
 /* Wakes up all threads, if any, waiting on COND (protected by
    LOCK).  LOCK must be held before calling this function.
 
+   All the waiters are made ready, highest priority first, in a
+   single critical section, and only then do we decide whether to
+   yield, so that waking many threads costs one reschedule rather
+   than one per waiter.
+
    An interrupt handler cannot acquire a lock, so it does not
    make sense to try to signal a condition variable within an
    interrupt handler. */
 void
 cond_broadcast (struct condition *cond, struct lock *lock) 
 {
+  enum intr_level old_level;
+
   ASSERT (cond != NULL);
   ASSERT (lock != NULL);
+  ASSERT (!intr_context ());
+  ASSERT (lock_held_by_current_thread (lock));
 
-  while (!list_empty (&cond->waiters))
-    cond_signal (cond, lock);
+  /* With interrupts off, sema_up() does not yield. */
+  old_level = intr_disable ();
+  while (!heap_empty (&cond->waiters)) 
+    {
+      struct semaphore_elem *waiter
+        = heap_entry (heap_pop_min (&cond->waiters),
+                      struct semaphore_elem, elem);
+      waiter->thread->wait_cond = NULL;
+      sema_up (&waiter->semaphore);
+    }
+  intr_set_level (old_level);
+
+  if (old_level == INTR_ON)
+    thread_yield_if_outranked ();
+}
+
+/* Moves T, whose priority has just changed, to its new place
+   among the waiters of the semaphore or condition variable that
+   it is waiting on, if any.  Interrupts must be off. */
+void
+synch_reorder_waiter (struct thread *t) 
+{
+  ASSERT (intr_get_level () == INTR_OFF);
+
+  if (t->wait_cond != NULL) 
+    {
+      /* A condition variable waiter is alone on its semaphore, so
+         only its place in the condition's heap matters. */
+      struct semaphore_elem *waiter
+        = (struct semaphore_elem *) ((uint8_t *) t->wait_sema
+                                     - offsetof (struct semaphore_elem,
+                                                 semaphore));
+      heap_remove (&t->wait_cond->waiters, &waiter->elem);
+      heap_insert (&t->wait_cond->waiters, &waiter->elem);
+    }
+  else if (t->wait_sema != NULL && t->status == THREAD_BLOCKED) 
+    {
+      heap_remove (&t->wait_sema->waiters, &t->heap_elem);
+      heap_insert (&t->wait_sema->waiters, &t->heap_elem);
+    }
+}
+
+/* Initializes RWLOCK.  A reader-writer lock may be held by any
+   number of readers at once ("shared"), or by a single writer
+   ("exclusive").  Writers are preferred: once a writer is
+   waiting, new readers wait behind it, so that a steady stream of
+   readers cannot starve writers.  Waiters are woken in priority
+   order, through condition variables.
+
+   A reader-writer lock is not recursive, and unlike a lock, does
+   not donate priority to the threads that hold it. */
+void
+rwlock_init (struct rwlock *rwlock) 
+{
+  ASSERT (rwlock != NULL);
+
+  lock_init (&rwlock->lock);
+  cond_init (&rwlock->read_ok);
+  cond_init (&rwlock->write_ok);
+  cond_init (&rwlock->upgrade_ok);
+  rwlock->readers = 0;
+  rwlock->writers_waiting = 0;
+  rwlock->writer = NULL;
+  rwlock->upgrader = NULL;
+}
+
+/* Acquires RWLOCK for reading, sleeping while a writer holds it
+   or is waiting for it.
+
+   This function may sleep, so it must not be called within an
+   interrupt handler. */
+void
+rwlock_acquire_read (struct rwlock *rwlock) 
+{
+  ASSERT (rwlock != NULL);
+  ASSERT (!intr_context ());
+
+  lock_acquire (&rwlock->lock);
+  while (rwlock->writer != NULL || rwlock->writers_waiting > 0
+         || rwlock->upgrader != NULL)
+    cond_wait (&rwlock->read_ok, &rwlock->lock);
+  rwlock->readers++;
+  lock_release (&rwlock->lock);
+}
+
+/* Releases RWLOCK, which the current thread must hold for
+   reading.  The last reader out lets in an upgrading reader, if
+   any, or else a waiting writer. */
+void
+rwlock_release_read (struct rwlock *rwlock) 
+{
+  ASSERT (rwlock != NULL);
+
+  lock_acquire (&rwlock->lock);
+  ASSERT (rwlock->readers > 0);
+  rwlock->readers--;
+  if (rwlock->upgrader != NULL && rwlock->readers == 1)
+    cond_signal (&rwlock->upgrade_ok, &rwlock->lock);
+  else if (rwlock->readers == 0 && rwlock->writers_waiting > 0)
+    cond_signal (&rwlock->write_ok, &rwlock->lock);
+  lock_release (&rwlock->lock);
+}
+
+/* Acquires RWLOCK for writing, sleeping until no other thread
+   holds it.
+
+   This function may sleep, so it must not be called within an
+   interrupt handler. */
+void
+rwlock_acquire_write (struct rwlock *rwlock) 
+{
+  struct thread *curr = thread_current ();
+
+  ASSERT (rwlock != NULL);
+  ASSERT (!intr_context ());
+  ASSERT (rwlock->writer != curr);
+
+  lock_acquire (&rwlock->lock);
+  rwlock->writers_waiting++;
+  while (rwlock->writer != NULL || rwlock->readers > 0)
+    cond_wait (&rwlock->write_ok, &rwlock->lock);
+  rwlock->writers_waiting--;
+  rwlock->writer = curr;
+  lock_release (&rwlock->lock);
+}
+
+/* Releases RWLOCK, which the current thread must hold for
+   writing.  Hands RWLOCK to the next writer, if one is waiting,
+   or else to all the waiting readers. */
+void
+rwlock_release_write (struct rwlock *rwlock) 
+{
+  ASSERT (rwlock != NULL);
+  ASSERT (rwlock_held_for_write_by_current_thread (rwlock));
+
+  lock_acquire (&rwlock->lock);
+  rwlock->writer = NULL;
+  if (rwlock->writers_waiting > 0)
+    cond_signal (&rwlock->write_ok, &rwlock->lock);
+  else
+    cond_broadcast (&rwlock->read_ok, &rwlock->lock);
+  lock_release (&rwlock->lock);
+}
+
+/* Converts the current thread's hold on RWLOCK from shared to
+   exclusive, sleeping until every other reader has released it.
+   An upgrading reader goes ahead of waiting writers.
+
+   Returns true if successful.  Only one reader can be upgrading
+   at a time, since two would wait for each other forever, so
+   fails and returns false if another reader is already doing so.
+   The current thread then still holds RWLOCK for reading, and
+   must release it to let the other reader proceed. */
+bool
+rwlock_upgrade (struct rwlock *rwlock) 
+{
+  struct thread *curr = thread_current ();
+
+  ASSERT (rwlock != NULL);
+  ASSERT (!intr_context ());
+
+  lock_acquire (&rwlock->lock);
+  ASSERT (rwlock->readers > 0);
+  if (rwlock->upgrader != NULL) 
+    {
+      lock_release (&rwlock->lock);
+      return false;
+    }
+  rwlock->upgrader = curr;
+  while (rwlock->readers > 1)
+    cond_wait (&rwlock->upgrade_ok, &rwlock->lock);
+  rwlock->upgrader = NULL;
+  rwlock->readers = 0;
+  rwlock->writer = curr;
+  lock_release (&rwlock->lock);
+  return true;
+}
+
+/* Converts the current thread's hold on RWLOCK from exclusive to
+   shared, without letting any writer in between.  Waiting
+   readers are let in too, unless a writer is waiting. */
+void
+rwlock_downgrade (struct rwlock *rwlock) 
+{
+  ASSERT (rwlock != NULL);
+  ASSERT (rwlock_held_for_write_by_current_thread (rwlock));
+
+  lock_acquire (&rwlock->lock);
+  rwlock->writer = NULL;
+  rwlock->readers = 1;
+  if (rwlock->writers_waiting == 0)
+    cond_broadcast (&rwlock->read_ok, &rwlock->lock);
+  lock_release (&rwlock->lock);
+}
+
+/* Returns true if the current thread holds RWLOCK for writing,
+   false otherwise.  (It is not possible to tell which threads
+   hold a reader-writer lock for reading.) */
+bool
+rwlock_held_for_write_by_current_thread (const struct rwlock *rwlock) 
+{
+  ASSERT (rwlock != NULL);
+
+  return rwlock->writer == thread_current ();
+}
+
+/* Donates the priority of T, which is about to wait for
+   T->waiting_lock, along the chain of lock holders that T's wait
+   depends on, stopping at a holder whose priority is at least
+   T's or after DONATION_DEPTH locks.  Interrupts must be off. */
+static void
+donate_priority (struct thread *t) 
+{
+  struct lock *lock = t->waiting_lock;
+  int depth;
+
+  ASSERT (intr_get_level () == INTR_OFF);
+
+  for (depth = 0; lock != NULL && depth < DONATION_DEPTH; depth++) 
+    {
+      struct thread *holder = lock->holder;
+
+      if (holder == NULL || holder->priority >= t->priority)
+        break;
+      thread_donate_priority (holder, t->priority);
+      lock = holder->waiting_lock;
+    }
+}
+
+/* Orders semaphore waiters by descending priority, then by
+   ascending sequence number. */
+static bool
+sema_waiter_less (const struct heap_elem *a_, const struct heap_elem *b_,
+                  void *aux UNUSED) 
+{
+  const struct thread *a = heap_entry (a_, struct thread, heap_elem);
+  const struct thread *b = heap_entry (b_, struct thread, heap_elem);
+
+  if (a->priority != b->priority)
+    return a->priority > b->priority;
+  return a->wait_seq < b->wait_seq;
+}
+
+/* Orders condition variable waiters by descending priority of
+   the waiting thread, then by ascending sequence number. */
+static bool
+cond_waiter_less (const struct heap_elem *a_, const struct heap_elem *b_,
+                  void *aux UNUSED) 
+{
+  const struct semaphore_elem *a
+    = heap_entry (a_, struct semaphore_elem, elem);
+  const struct semaphore_elem *b
+    = heap_entry (b_, struct semaphore_elem, elem);
+
+  if (a->thread->priority != b->thread->priority)
+    return a->thread->priority > b->thread->priority;
+  return a->seq < b->seq;
 }
@@ -1,14 +1,17 @@
 #ifndef THREADS_SYNCH_H
 #define THREADS_SYNCH_H
 
+#include <heap.h>
 #include <list.h>
 #include <stdbool.h>
 
+struct thread;
+
 /* A counting semaphore. */
 struct semaphore 
   {
     unsigned value;             /* Current value. */
-    struct list waiters;        /* List of waiting threads. */
+    struct heap waiters;        /* Waiting threads, highest priority first. */
   };
 
 void sema_init (struct semaphore *, unsigned value);
@@ -20,20 +23,34 @@ void sema_self_test (void);
 /* Lock. */
 struct lock 
   {
-    struct thread *holder;      /* Thread holding lock (for debugging). */
+    struct thread *holder;      /* Thread holding lock, or null. */
     struct semaphore semaphore; /* Binary semaphore controlling access. */
+    struct list_elem elem;      /* Element in holder's held_locks. */
+#ifdef LOCKSTAT
+    struct lockstat *stat;      /* Statistics for locks of this name. */
+    int64_t acquire_tick;       /* When the holder acquired it. */
+#endif
   };
 
-void lock_init (struct lock *);
+/* Initializes LOCK.  When lock statistics are compiled in, they
+   are kept under the text of the LOCK argument, e.g.
+   "&console_lock", so every lock initialized by the same
+   statement shares one entry.  Use lock_init_named() to choose
+   a name explicitly. */
+#define lock_init(LOCK) lock_init_named (LOCK, #LOCK)
+void lock_init_named (struct lock *, const char *name);
 void lock_acquire (struct lock *);
 bool lock_try_acquire (struct lock *);
 void lock_release (struct lock *);
 bool lock_held_by_current_thread (const struct lock *);
+#ifdef LOCKSTAT
+void lock_print_stats (void);
+#endif
 
 /* Condition variable. */
 struct condition 
   {
-    struct list waiters;        /* List of waiting threads. */
+    struct heap waiters;        /* Waiting threads, highest priority first. */
   };
 
 void cond_init (struct condition *);
@@ -41,6 +58,30 @@ void cond_wait (struct condition *, struct lock *);
 void cond_signal (struct condition *, struct lock *);
 void cond_broadcast (struct condition *, struct lock *);
 
+void synch_reorder_waiter (struct thread *);
+
+/* Reader-writer lock. */
+struct rwlock 
+  {
+    struct lock lock;           /* Protects the members below. */
+    struct condition read_ok;   /* Signaled when readers may enter. */
+    struct condition write_ok;  /* Signaled when a writer may enter. */
+    struct condition upgrade_ok; /* Signaled when upgrader may enter. */
+    unsigned readers;           /* Number of threads holding shared. */
+    unsigned writers_waiting;   /* Number of threads waiting for exclusive. */
+    struct thread *writer;      /* Thread holding exclusive, or null. */
+    struct thread *upgrader;    /* Reader waiting to upgrade, or null. */
+  };
+
+void rwlock_init (struct rwlock *);
+void rwlock_acquire_read (struct rwlock *);
+void rwlock_release_read (struct rwlock *);
+void rwlock_acquire_write (struct rwlock *);
+void rwlock_release_write (struct rwlock *);
+bool rwlock_upgrade (struct rwlock *);
+void rwlock_downgrade (struct rwlock *);
+bool rwlock_held_for_write_by_current_thread (const struct rwlock *);
+
 /* Optimization barrier.
 
    The compiler will not reorder operations across an
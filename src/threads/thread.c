@@ -11,6 +11,7 @@
 #include "threads/switch.h"
 #include "threads/synch.h"
 #include "threads/vaddr.h"
+#include "devices/timer.h"
 #ifdef USERPROG
 #include "userprog/process.h"
 #endif
@@ -25,9 +26,28 @@
    Do not modify this value. */
 #define THREAD_BASIC 0xd42df210
 
-/* List of processes in THREAD_READY state, that is, processes
-   that are ready to run but not actually running. */
-static struct list ready_list;
+/* Run queues of processes in THREAD_READY state, that is,
+   processes that are ready to run but not actually running.
+   There is one FIFO queue per priority level.  Bit N of
+   ready_mask is set if and only if ready_queues[N] is nonempty,
+   so the highest-priority ready thread can be found with a
+   single bit scan instead of a walk over every ready thread. */
+static struct list ready_queues[PRI_MAX - PRI_MIN + 1];
+static uint64_t ready_mask;
+static int ready_cnt;           /* Number of threads in ready_queues. */
+
+/* Under the stride scheduler, threads in THREAD_READY state are
+   kept instead in stride_queue, ordered by pass. */
+static struct heap stride_queue;
+
+/* Ready threads in the deadline class that have budget left, in
+   order of absolute deadline.  They run ahead of every thread in
+   the queues above. */
+static struct heap deadline_queue;
+
+/* List of all processes.  Processes are added to this list
+   when they are first created and removed when they exit. */
+static struct list all_list;
 
 /* Idle thread. */
 static struct thread *idle_thread;
@@ -60,14 +80,118 @@ static unsigned thread_ticks;   /* # of timer ticks since last yield. */
    Controlled by kernel command-line option "-o mlfqs". */
 bool thread_mlfqs;
 
+/* If true, use stride scheduler instead.
+   Controlled by kernel command-line option "-stride". */
+bool thread_stride;
+
+/* Cache of thread pages.
+
+   The pages of threads that have exited are kept here for
+   thread_create() to reuse without a trip through the page
+   allocator.  Only the struct thread at
+   the bottom of a reused page is reinitialized; the stack above
+   it is not zeroed, because a new thread never reads its stack
+   before writing it.  The pages are linked through their first
+   word and protected by disabling interrupts, since
+   schedule_tail() adds to the cache with interrupts off.
+
+   schedule_tail() cannot give pages back to the page allocator,
+   which takes a lock, so it adds every dead thread's page to the
+   cache.  thread_create() later trims the cache back to
+   THREAD_CACHE_MAX pages, and the page allocator drains it when
+   it runs low on pages.  The idle thread must not trim it: it
+   would have to block on the page allocator's lock, and a
+   thread that waited for that lock would donate its priority
+   to the idle thread, which is never in a run queue. */
+#define THREAD_CACHE_MAX 16     /* Maximum number of cached pages. */
+static void *thread_cache;      /* Most recently cached page. */
+static size_t thread_cache_cnt; /* Number of cached pages. */
+static long long thread_cache_hits;   /* Allocations from the cache. */
+static long long thread_cache_misses; /* Allocations from palloc. */
+
+/* Stride scheduler.
+
+   Each thread holds some number of tickets and advances its pass
+   by its stride, STRIDE1 / tickets, for every tick that it runs.
+   The ready thread with the least pass runs next, so over any
+   interval each thread receives CPU time in proportion to its
+   tickets, with an error of at most a few time slices.
+   global_pass is the pass of the last thread dispatched: a
+   thread that becomes ready with a lower pass, because it was
+   created or slept for a while, starts from global_pass instead,
+   so that it cannot claim the CPU time it did not use. */
+#define STRIDE1 (1 << 20)       /* Stride of a thread with one ticket. */
+static int64_t global_pass;     /* Pass of last thread dispatched. */
+
+/* Deadline scheduling class.
+
+   A thread that declares with thread_set_deadline() that it needs
+   RUNTIME ticks of CPU time every PERIOD ticks is admitted only
+   if the total utilization, the sum of RUNTIME / PERIOD over all
+   admitted threads, stays within DEADLINE_UTIL_MAX.  Among the
+   admitted threads, the one with the earliest absolute deadline
+   runs first, ahead of all other threads, so by the EDF
+   schedulability bound each meets its deadlines.
+
+   Each tick that such a thread runs consumes a tick of its
+   budget.  A thread that exhausts its budget is scheduled like
+   any other thread until a timeout at the end of its period
+   replenishes the budget and moves its deadline a period ahead,
+   so an overrunning thread cannot starve the rest of the
+   system. */
+#define DEADLINE_UTIL_MAX (FP_ONE * 9 / 10) /* Utilization bound. */
+static fixed_t deadline_util;   /* Utilization of admitted threads. */
+
+/* Multi-level feedback queue scheduler.
+
+   4.4BSD recomputes every thread's recent_cpu and priority once
+   a second, which makes that timer interrupt take time in
+   proportion to the number of threads.  Instead, once a second
+   we only update the load average and record that second's
+   recent_cpu decay coefficient in decay_history[].  A thread's
+   recent_cpu is decayed lazily, by replaying the coefficients
+   for the seconds since its recent_cpu_epoch, whenever it is
+   needed.  In addition, each tick refreshes the next
+   SWEEP_BATCH threads in all_list, so that the run queues
+   settle shortly after each second and no thread falls more
+   than DECAY_HISTORY seconds behind.  The work per tick is thus
+   bounded by a constant, whatever the number of threads. */
+#define DECAY_HISTORY 64        /* Seconds of decay coefficients kept. */
+#define SWEEP_BATCH 8           /* Threads refreshed per tick. */
+static fixed_t load_avg;        /* System load average. */
+static int64_t mlfqs_seconds;   /* Number of seconds of decay so far. */
+static fixed_t decay_history[DECAY_HISTORY]; /* Coefficient by second. */
+static struct list_elem *sweep_cursor;       /* Next thread to refresh. */
+
 static void kernel_thread (thread_func *, void *aux);
 
 static void idle (void *aux UNUSED);
 static struct thread *running_thread (void);
 static struct thread *next_thread_to_run (void);
+static void ready_push (struct thread *);
+static void ready_remove (struct thread *);
+static int ready_max_priority (void);
+static bool stride_less (const struct heap_elem *, const struct heap_elem *,
+                         void *aux);
+static void stride_join (struct thread *);
+static bool deadline_active (const struct thread *);
+static bool deadline_less (const struct heap_elem *, const struct heap_elem *,
+                           void *aux);
+static void deadline_replenish (void *t_);
+static void deadline_leave (struct thread *);
+static bool mlfqs_managed (const struct thread *);
+static void mlfqs_tick (struct thread *);
+static void mlfqs_catch_up (struct thread *);
+static void mlfqs_refresh (struct thread *);
+static int mlfqs_priority (const struct thread *);
+static void change_priority (struct thread *, int priority);
 static void init_thread (struct thread *, const char *name, int priority);
 static bool is_thread (struct thread *) UNUSED;
 static void *alloc_frame (struct thread *, size_t size);
+static struct thread *thread_page_alloc (void);
+static void thread_page_free (struct thread *);
+static void thread_cache_trim (void);
+static size_t thread_cache_drain (void);
 static void schedule (void);
 void schedule_tail (struct thread *prev);
 static tid_t allocate_tid (void);
@@ -91,10 +215,19 @@ static tid_t allocate_tid (void);
 void
 thread_init (void) 
 {
+  int i;
+
   ASSERT (intr_get_level () == INTR_OFF);
 
   lock_init (&tid_lock);
-  list_init (&ready_list);
+  palloc_add_reclaimer (thread_cache_drain);
+  for (i = 0; i < PRI_MAX - PRI_MIN + 1; i++)
+    list_init (&ready_queues[i]);
+  ready_mask = 0;
+  heap_init (&stride_queue, stride_less, NULL);
+  heap_init (&deadline_queue, deadline_less, NULL);
+  list_init (&all_list);
+  sweep_cursor = list_end (&all_list);
 
   /* Set up a thread structure for the running thread. */
   initial_thread = running_thread ();
@@ -137,6 +270,16 @@ thread_tick (void)
   else
     kernel_ticks++;
 
+  if (thread_mlfqs)
+    mlfqs_tick (t);
+  else if (thread_stride && t != idle_thread)
+    t->pass += t->stride;
+
+  /* Charge a deadline thread's budget, and once it is exhausted
+     let the thread fall back to its place among the others. */
+  if (deadline_active (t) && --t->dl_budget == 0)
+    intr_yield_on_return ();
+
   /* Enforce preemption. */
   if (++thread_ticks >= TIME_SLICE)
     intr_yield_on_return ();
@@ -148,6 +291,8 @@ thread_print_stats (void)
 {
   printf ("Thread: %lld idle ticks, %lld kernel ticks, %lld user ticks\n",
           idle_ticks, kernel_ticks, user_ticks);
+  printf ("Thread: %lld pages reused, %lld pages allocated\n",
+          thread_cache_hits, thread_cache_misses);
 }
 
 /* Creates a new kernel thread named NAME with the given initial
@@ -162,9 +307,8 @@ thread_print_stats (void)
    scheduled.  Use a semaphore or some other form of
    synchronization if you need to ensure ordering.
 
-   The code provided sets the new thread's `priority' member to
-   PRIORITY, but no actual priority scheduling is implemented.
-   Priority scheduling is the goal of Problem 1-3. */
+   If the new thread has a higher priority than the running
+   thread, the running thread yields to it immediately. */
 tid_t
 thread_create (const char *name, int priority,
                thread_func *function, void *aux) 
@@ -178,13 +322,28 @@ thread_create (const char *name, int priority,
   ASSERT (function != NULL);
 
   /* Allocate thread. */
-  t = palloc_get_page (PAL_ZERO);
+  thread_cache_trim ();
+  t = thread_page_alloc ();
   if (t == NULL)
     return TID_ERROR;
 
-  /* Initialize thread. */
+  /* Initialize thread.  Under the multi-level feedback queue
+     scheduler, the new thread inherits our niceness and
+     recent_cpu, which determine its priority. */
   init_thread (t, name, priority);
   tid = t->tid = allocate_tid ();
+  if (mlfqs_managed (t)) 
+    {
+      struct thread *curr = thread_current ();
+      enum intr_level old_level = intr_disable ();
+
+      mlfqs_catch_up (curr);
+      t->nice = curr->nice;
+      t->recent_cpu = curr->recent_cpu;
+      t->recent_cpu_epoch = mlfqs_seconds;
+      t->priority = priority = mlfqs_priority (t);
+      intr_set_level (old_level);
+    }
 
   /* Stack frame for kernel_thread(). */
   kf = alloc_frame (t, sizeof *kf);
@@ -203,6 +362,10 @@ thread_create (const char *name, int priority,
   /* Add to run queue. */
   thread_unblock (t);
 
+  /* Let the new thread run if it outranks us. */
+  if (priority > thread_get_priority ())
+    thread_yield ();
+
   return tid;
 }
 
@@ -239,7 +402,14 @@ thread_unblock (struct thread *t)
 
   old_level = intr_disable ();
   ASSERT (t->status == THREAD_BLOCKED);
-  list_push_back (&ready_list, &t->elem);
+  if (mlfqs_managed (t))
+    {
+      mlfqs_catch_up (t);
+      t->priority = mlfqs_priority (t);
+    }
+  else if (thread_stride)
+    stride_join (t);
+  ready_push (t);
   t->status = THREAD_READY;
   intr_set_level (old_level);
 }
@@ -287,10 +457,16 @@ thread_exit (void)
 #ifdef USERPROG
   process_exit ();
 #endif
+  malloc_thread_exit ();
 
-  /* Just set our status to dying and schedule another process.
-     We will be destroyed during the call to schedule_tail(). */
+  /* Remove ourselves from the list of all threads, set our status
+     to dying, and schedule another process.  We will be destroyed
+     during the call to schedule_tail(). */
   intr_disable ();
+  deadline_leave (thread_current ());
+  if (sweep_cursor == &thread_current ()->allelem)
+    sweep_cursor = list_next (sweep_cursor);
+  list_remove (&thread_current ()->allelem);
   thread_current ()->status = THREAD_DYING;
   schedule ();
   NOT_REACHED ();
@@ -308,57 +484,261 @@ thread_yield (void)
 
   old_level = intr_disable ();
   if (curr != idle_thread) 
-    list_push_back (&ready_list, &curr->elem);
+    ready_push (curr);
   curr->status = THREAD_READY;
   schedule ();
   intr_set_level (old_level);
 }
 
-/* Sets the current thread's priority to NEW_PRIORITY. */
+/* Yields the CPU if some ready thread should run instead of the
+   running thread. */
+void
+thread_yield_if_outranked (void) 
+{
+  struct thread *curr = thread_current ();
+  enum intr_level old_level;
+  bool yield;
+
+  ASSERT (!intr_context ());
+
+  old_level = intr_disable ();
+  if (!heap_empty (&deadline_queue))
+    yield = thread_preempts (heap_entry (heap_min (&deadline_queue),
+                                         struct thread, heap_elem));
+  else
+    yield = !deadline_active (curr) && ready_max_priority () > curr->priority;
+  intr_set_level (old_level);
+
+  if (yield)
+    thread_yield ();
+}
+
+/* Sets the current thread's base priority to NEW_PRIORITY.  Its
+   effective priority is also lowered to NEW_PRIORITY, unless
+   threads waiting on locks it holds are donating a higher one.
+   Yields if some ready thread now has a higher priority.
+   Ignored under the multi-level feedback queue scheduler, which
+   computes priorities itself. */
 void
 thread_set_priority (int new_priority) 
 {
-  thread_current ()->priority = new_priority;
+  enum intr_level old_level;
+
+  ASSERT (PRI_MIN <= new_priority && new_priority <= PRI_MAX);
+
+  if (thread_mlfqs)
+    return;
+
+  old_level = intr_disable ();
+  thread_current ()->base_priority = new_priority;
+  thread_update_priority (thread_current ());
+  intr_set_level (old_level);
+
+  thread_yield_if_outranked ();
 }
 
-/* Returns the current thread's priority. */
+/* Returns the current thread's effective priority. */
 int
 thread_get_priority (void) 
 {
   return thread_current ()->priority;
 }
 
-/* Sets the current thread's nice value to NICE. */
+/* Raises T's effective priority to PRIORITY, if it is lower, on
+   behalf of a thread waiting for a lock that T holds.  Does not
+   yield.  Interrupts must be off. */
 void
-thread_set_nice (int nice UNUSED) 
+thread_donate_priority (struct thread *t, int priority) 
 {
-  /* Not yet implemented. */
+  ASSERT (intr_get_level () == INTR_OFF);
+  ASSERT (is_thread (t));
+
+  if (priority > t->priority)
+    change_priority (t, priority);
+}
+
+/* Recomputes T's effective priority as the greatest of its base
+   priority and the priorities of the highest-priority waiters on
+   each of the locks it holds.  Takes time proportional to the
+   number of locks T holds.  Does not yield.  Interrupts must be
+   off. */
+void
+thread_update_priority (struct thread *t) 
+{
+  int priority = t->base_priority;
+  struct list_elem *e;
+
+  ASSERT (intr_get_level () == INTR_OFF);
+  ASSERT (is_thread (t));
+
+  for (e = list_begin (&t->held_locks); e != list_end (&t->held_locks);
+       e = list_next (e))
+    {
+      struct lock *lock = list_entry (e, struct lock, elem);
+      struct heap *waiters = &lock->semaphore.waiters;
+
+      if (!heap_empty (waiters)) 
+        {
+          struct thread *waiter = heap_entry (heap_min (waiters),
+                                              struct thread, heap_elem);
+          if (waiter->priority > priority)
+            priority = waiter->priority;
+        }
+    }
+
+  if (priority != t->priority)
+    change_priority (t, priority);
+}
+
+/* Sets the current thread's nice value to NICE and recomputes
+   its priority.  Yields if some ready thread now has a higher
+   priority. */
+void
+thread_set_nice (int nice) 
+{
+  struct thread *curr = thread_current ();
+  enum intr_level old_level;
+
+  ASSERT (NICE_MIN <= nice && nice <= NICE_MAX);
+
+  old_level = intr_disable ();
+  mlfqs_catch_up (curr);
+  curr->nice = nice;
+  if (thread_mlfqs)
+    curr->priority = mlfqs_priority (curr);
+  intr_set_level (old_level);
+
+  thread_yield_if_outranked ();
 }
 
 /* Returns the current thread's nice value. */
 int
 thread_get_nice (void) 
 {
-  /* Not yet implemented. */
-  return 0;
+  return thread_current ()->nice;
 }
 
 /* Returns 100 times the system load average. */
 int
 thread_get_load_avg (void) 
 {
-  /* Not yet implemented. */
-  return 0;
+  enum intr_level old_level = intr_disable ();
+  int load_avg_100 = fp_round (100 * load_avg);
+  intr_set_level (old_level);
+
+  return load_avg_100;
 }
 
 /* Returns 100 times the current thread's recent_cpu value. */
 int
 thread_get_recent_cpu (void) 
 {
-  /* Not yet implemented. */
-  return 0;
+  struct thread *curr = thread_current ();
+  enum intr_level old_level;
+  int recent_cpu_100;
+
+  old_level = intr_disable ();
+  mlfqs_catch_up (curr);
+  recent_cpu_100 = fp_round (100 * curr->recent_cpu);
+  intr_set_level (old_level);
+
+  return recent_cpu_100;
 }
 
+/* Sets the current thread's number of tickets to TICKETS, which
+   determines its share of the CPU under the stride scheduler.
+   Takes effect from the next tick. */
+void
+thread_set_tickets (int tickets) 
+{
+  struct thread *curr = thread_current ();
+  enum intr_level old_level;
+
+  ASSERT (TICKETS_MIN <= tickets && tickets <= TICKETS_MAX);
+
+  old_level = intr_disable ();
+  curr->tickets = tickets;
+  curr->stride = STRIDE1 / tickets;
+  intr_set_level (old_level);
+}
+
+/* Returns the current thread's number of tickets. */
+int
+thread_get_tickets (void) 
+{
+  return thread_current ()->tickets;
+}
+
+/* Admits the current thread to the deadline scheduling class
+   as needing RUNTIME ticks of CPU time in every period of PERIOD
+   ticks, starting now.  If the thread is already in the class,
+   its reservation is replaced.  Returns true if successful,
+   false if admitting the thread would take the total
+   utilization of the class above its bound, in which case the
+   thread's existing reservation, if any, is unchanged. */
+bool
+thread_set_deadline (int64_t runtime, int64_t period) 
+{
+  struct thread *curr = thread_current ();
+  enum intr_level old_level;
+  fixed_t util;
+
+  ASSERT (0 < runtime && runtime <= period);
+
+  util = runtime * FP_ONE / period;
+  if (util == 0)
+    util = 1;
+
+  old_level = intr_disable ();
+  if (deadline_util - curr->dl_util + util > DEADLINE_UTIL_MAX) 
+    {
+      intr_set_level (old_level);
+      return false;
+    }
+  deadline_util += util - curr->dl_util;
+  curr->dl_util = util;
+  curr->dl_runtime = curr->dl_budget = runtime;
+  curr->dl_period = period;
+  curr->dl_deadline = timer_ticks () + period;
+  timer_add (&curr->dl_timeout, curr->dl_deadline, deadline_replenish, curr);
+  intr_set_level (old_level);
+
+  thread_yield_if_outranked ();
+  return true;
+}
+
+/* Removes the current thread from the deadline scheduling class,
+   releasing its reservation.  Does nothing if it is not in the
+   class. */
+void
+thread_clear_deadline (void) 
+{
+  enum intr_level old_level = intr_disable ();
+  deadline_leave (thread_current ());
+  intr_set_level (old_level);
+
+  thread_yield_if_outranked ();
+}
+
+/* Returns true if T, which must be ready, should run instead of
+   the running thread: because T is a deadline thread whose
+   deadline is earlier, or because neither is a deadline thread
+   and T has the higher priority.  Interrupts must be off. */
+bool
+thread_preempts (const struct thread *t) 
+{
+  struct thread *curr = thread_current ();
+
+  ASSERT (intr_get_level () == INTR_OFF);
+
+  if (deadline_active (t))
+    return !deadline_active (curr) || t->dl_deadline < curr->dl_deadline;
+  else if (deadline_active (curr))
+    return false;
+  else
+    return t->priority > curr->priority;
+}
+
 /* Idle thread.  Executes when no other thread is ready to run.
 
    The idle thread is initially put on the ready list by
@@ -377,6 +757,9 @@ idle (void *idle_started_ UNUSED)
 
   for (;;) 
     {
+      /* Use the time for zeroing pages in advance. */
+      palloc_idle ();
+
       /* Let someone else run. */
       intr_disable ();
       thread_block ();
@@ -429,11 +812,37 @@ is_thread (struct thread *t)
   return t != NULL && t->magic == THREAD_MAGIC;
 }
 
+/* Sets T's effective priority to PRIORITY, moving T to the right
+   run queue if it is ready, and to its new place among the
+   waiters it is queued with, if any.  T may be queued on a
+   condition variable even if it is not blocked, because
+   cond_wait() queues it before releasing the lock and going to
+   sleep.  If T is waiting for a lock, the lock's holder is not
+   affected.  Interrupts must be off. */
+static void
+change_priority (struct thread *t, int priority) 
+{
+  ASSERT (intr_get_level () == INTR_OFF);
+  ASSERT (PRI_MIN <= priority && priority <= PRI_MAX);
+
+  if (t->status == THREAD_READY) 
+    {
+      ready_remove (t);
+      t->priority = priority;
+      ready_push (t);
+    }
+  else
+    t->priority = priority;
+  synch_reorder_waiter (t);
+}
+
 /* Does basic initialization of T as a blocked thread named
    NAME. */
 static void
 init_thread (struct thread *t, const char *name, int priority)
 {
+  enum intr_level old_level;
+
   ASSERT (t != NULL);
   ASSERT (PRI_MIN <= priority && priority <= PRI_MAX);
   ASSERT (name != NULL);
@@ -442,8 +851,115 @@ init_thread (struct thread *t, const char *name, int priority)
   t->status = THREAD_BLOCKED;
   strlcpy (t->name, name, sizeof t->name);
   t->stack = (uint8_t *) t + PGSIZE;
-  t->priority = priority;
+  t->priority = t->base_priority = priority;
+  list_init (&t->held_locks);
+  t->nice = NICE_DEFAULT;
+  t->tickets = TICKETS_DEFAULT;
+  t->stride = STRIDE1 / TICKETS_DEFAULT;
+  t->recent_cpu_epoch = mlfqs_seconds;
   t->magic = THREAD_MAGIC;
+
+  old_level = intr_disable ();
+  list_push_back (&all_list, &t->allelem);
+  intr_set_level (old_level);
+}
+
+/* Returns a page for a new thread, from the thread page cache if
+   possible, or a null pointer if none is available. */
+static struct thread *
+thread_page_alloc (void) 
+{
+  enum intr_level old_level;
+  void *page;
+
+  old_level = intr_disable ();
+  page = thread_cache;
+  if (page != NULL) 
+    {
+      thread_cache = *(void **) page;
+      thread_cache_cnt--;
+      thread_cache_hits++;
+    }
+  intr_set_level (old_level);
+
+  if (page == NULL) 
+    {
+      page = palloc_get_page (0);
+      if (page != NULL)
+        thread_cache_misses++;
+    }
+  return page;
+}
+
+/* Adds the page of dead thread T to the thread page cache, even
+   if that takes the cache past THREAD_CACHE_MAX pages, because
+   the page allocator may not be called with interrupts off.
+   Interrupts must be off. */
+static void
+thread_page_free (struct thread *t) 
+{
+  ASSERT (intr_get_level () == INTR_OFF);
+
+  *(void **) t = thread_cache;
+  thread_cache = t;
+  thread_cache_cnt++;
+}
+
+/* Returns the pages in the thread page cache beyond the first
+   THREAD_CACHE_MAX to the page allocator.  Must be called in
+   thread context, outside schedule_tail() and not from the idle
+   thread, because the page allocator takes a lock. */
+static void
+thread_cache_trim (void) 
+{
+  enum intr_level old_level;
+  void *excess = NULL;
+
+  ASSERT (!intr_context ());
+
+  old_level = intr_disable ();
+  while (thread_cache_cnt > THREAD_CACHE_MAX) 
+    {
+      void *page = thread_cache;
+      thread_cache = *(void **) page;
+      thread_cache_cnt--;
+      *(void **) page = excess;
+      excess = page;
+    }
+  intr_set_level (old_level);
+
+  while (excess != NULL) 
+    {
+      void *next = *(void **) excess;
+      palloc_free_page (excess);
+      excess = next;
+    }
+}
+
+/* Returns every page in the thread page cache to the page
+   allocator, and returns the number of pages freed.  Registered
+   with the page allocator as a reclaimer. */
+static size_t
+thread_cache_drain (void) 
+{
+  enum intr_level old_level;
+  void *page;
+  size_t cnt;
+
+  old_level = intr_disable ();
+  page = thread_cache;
+  cnt = thread_cache_cnt;
+  thread_cache = NULL;
+  thread_cache_cnt = 0;
+  intr_set_level (old_level);
+
+  while (page != NULL) 
+    {
+      void *next = *(void **) page;
+      palloc_free_page (page);
+      page = next;
+    }
+  return cnt;
 }
 
 /* Allocates a SIZE-byte frame at the top of thread T's stack and
@@ -459,18 +975,331 @@ alloc_frame (struct thread *t, size_t size)
   return t->stack;
 }
 
+/* Returns the index of the most significant set bit in MASK,
+   which must be nonzero.  Split into two 32-bit scans because
+   a 64-bit count-leading-zeros would call into libgcc, which we
+   do not link against. */
+static inline int
+highest_bit (uint64_t mask) 
+{
+  uint32_t hi = mask >> 32;
+  uint32_t lo = mask;
+
+  ASSERT (mask != 0);
+  if (hi != 0)
+    return 63 - __builtin_clz (hi);
+  else
+    return 31 - __builtin_clz (lo);
+}
+
+/* Appends T to the back of the run queue for its priority, or
+   under the stride scheduler inserts it into stride_queue.  A
+   deadline thread with budget left goes into deadline_queue
+   instead.  Interrupts must be off. */
+static void
+ready_push (struct thread *t) 
+{
+  int idx = t->priority - PRI_MIN;
+
+  ASSERT (intr_get_level () == INTR_OFF);
+  ASSERT (PRI_MIN <= t->priority && t->priority <= PRI_MAX);
+
+  if (deadline_active (t) || thread_stride) 
+    {
+      heap_insert (deadline_active (t) ? &deadline_queue : &stride_queue,
+                   &t->heap_elem);
+      ready_cnt++;
+      return;
+    }
+
+  list_push_back (&ready_queues[idx], &t->elem);
+  ready_mask |= (uint64_t) 1 << idx;
+  ready_cnt++;
+}
+
+/* Removes ready thread T from its run queue.  Interrupts must be
+   off, and T's priority and deadline state must not have changed
+   since ready_push() queued it. */
+static void
+ready_remove (struct thread *t) 
+{
+  int idx = t->priority - PRI_MIN;
+
+  ASSERT (intr_get_level () == INTR_OFF);
+  ASSERT (t->status == THREAD_READY);
+
+  if (deadline_active (t) || thread_stride) 
+    {
+      heap_remove (deadline_active (t) ? &deadline_queue : &stride_queue,
+                   &t->heap_elem);
+      ready_cnt--;
+      return;
+    }
+
+  list_remove (&t->elem);
+  if (list_empty (&ready_queues[idx]))
+    ready_mask &= ~((uint64_t) 1 << idx);
+  ready_cnt--;
+}
+
+/* Returns the priority of the highest-priority ready thread, or
+   PRI_MIN - 1 if no thread is ready.  Interrupts must be off.
+   The stride scheduler ignores priorities, and so, since
+   stride_queue does not use ready_mask, always returns PRI_MIN - 1
+   under it. */
+static int
+ready_max_priority (void) 
+{
+  ASSERT (intr_get_level () == INTR_OFF);
+
+  return ready_mask != 0 ? highest_bit (ready_mask) + PRI_MIN : PRI_MIN - 1;
+}
+
 /* Chooses and returns the next thread to be scheduled.  Should
    return a thread from the run queue, unless the run queue is
    empty.  (If the running thread can continue running, then it
    will be in the run queue.)  If the run queue is empty, return
-   idle_thread. */
+   idle_thread.
+
+   Takes the front of the highest-priority nonempty queue, so
+   threads of equal priority are scheduled round-robin.  Under
+   the stride scheduler, takes the thread with the least pass.
+   Either way, a ready deadline thread takes precedence. */
 static struct thread *
 next_thread_to_run (void) 
 {
-  if (list_empty (&ready_list))
+  struct list *queue;
+  struct thread *t;
+  int idx;
+
+  if (!heap_empty (&deadline_queue)) 
+    {
+      ready_cnt--;
+      return heap_entry (heap_pop_min (&deadline_queue),
+                         struct thread, heap_elem);
+    }
+
+  if (thread_stride) 
+    {
+      if (heap_empty (&stride_queue))
+        return idle_thread;
+      t = heap_entry (heap_pop_min (&stride_queue), struct thread, heap_elem);
+      global_pass = t->pass;
+      ready_cnt--;
+      return t;
+    }
+
+  if (ready_mask == 0)
     return idle_thread;
-  else
-    return list_entry (list_pop_front (&ready_list), struct thread, elem);
+
+  idx = highest_bit (ready_mask);
+  queue = &ready_queues[idx];
+  t = list_entry (list_pop_front (queue), struct thread, elem);
+  if (list_empty (queue))
+    ready_mask &= ~((uint64_t) 1 << idx);
+  ready_cnt--;
+  return t;
+}
+
+/* Orders threads in stride_queue by ascending pass, breaking
+   ties by tid so that the order is deterministic. */
+static bool
+stride_less (const struct heap_elem *a_, const struct heap_elem *b_,
+             void *aux UNUSED) 
+{
+  const struct thread *a = heap_entry (a_, struct thread, heap_elem);
+  const struct thread *b = heap_entry (b_, struct thread, heap_elem);
+
+  if (a->pass != b->pass)
+    return a->pass < b->pass;
+  return a->tid < b->tid;
+}
+
+/* Prepares T, which is about to become ready, to rejoin the
+   stride scheduler's competition for the CPU: a thread that has
+   fallen behind global_pass, because it is new or has been
+   blocked, resumes from global_pass.  Interrupts must be off. */
+static void
+stride_join (struct thread *t) 
+{
+  ASSERT (intr_get_level () == INTR_OFF);
+
+  if (t->pass < global_pass)
+    t->pass = global_pass;
+}
+
+/* Returns true if T is in the deadline scheduling class and has
+   budget left in its current period. */
+static bool
+deadline_active (const struct thread *t) 
+{
+  return t->dl_period != 0 && t->dl_budget > 0;
+}
+
+/* Orders threads in deadline_queue by ascending deadline,
+   breaking ties by tid. */
+static bool
+deadline_less (const struct heap_elem *a_, const struct heap_elem *b_,
+               void *aux UNUSED) 
+{
+  const struct thread *a = heap_entry (a_, struct thread, heap_elem);
+  const struct thread *b = heap_entry (b_, struct thread, heap_elem);
+
+  if (a->dl_deadline != b->dl_deadline)
+    return a->dl_deadline < b->dl_deadline;
+  return a->tid < b->tid;
+}
+
+/* Timeout function run at the end of deadline thread T_'s
+   period.  Starts T_'s next period with a full budget, moving it
+   into deadline_queue if it is ready. */
+static void
+deadline_replenish (void *t_) 
+{
+  struct thread *t = t_;
+  int64_t now = timer_ticks ();
+  bool ready = t->status == THREAD_READY;
+
+  if (ready)
+    ready_remove (t);
+  t->dl_budget = t->dl_runtime;
+  t->dl_deadline += t->dl_period;
+  if (t->dl_deadline <= now)
+    t->dl_deadline = now + t->dl_period;
+  if (ready) 
+    {
+      ready_push (t);
+      if (thread_preempts (t))
+        intr_yield_on_return ();
+    }
+  timer_add (&t->dl_timeout, t->dl_deadline, deadline_replenish, t);
+}
+
+/* Removes T, which must not be ready, from the deadline
+   scheduling class, if it is in it.  Interrupts must be off. */
+static void
+deadline_leave (struct thread *t) 
+{
+  ASSERT (intr_get_level () == INTR_OFF);
+  ASSERT (t->status != THREAD_READY);
+
+  if (t->dl_period == 0)
+    return;
+  timer_cancel (&t->dl_timeout);
+  deadline_util -= t->dl_util;
+  t->dl_util = 0;
+  t->dl_runtime = t->dl_budget = t->dl_period = 0;
+}
+
+/* Returns true if T's priority is computed by the multi-level
+   feedback queue scheduler.  The idle thread's priority is
+   always PRI_MIN, and so is that of any thread created before
+   the idle thread has started, which can only be the idle
+   thread itself. */
+static bool
+mlfqs_managed (const struct thread *t) 
+{
+  return thread_mlfqs && idle_thread != NULL && t != idle_thread;
+}
+
+/* Multi-level feedback queue bookkeeping for a timer tick, with
+   CURR the running thread.  Runs in an external interrupt
+   context and does a constant amount of work. */
+static void
+mlfqs_tick (struct thread *curr) 
+{
+  int64_t now = timer_ticks ();
+  int i;
+
+  if (curr != idle_thread) 
+    {
+      mlfqs_catch_up (curr);
+      curr->recent_cpu = fp_add_int (curr->recent_cpu, 1);
+    }
+
+  if (now % TIMER_FREQ == 0) 
+    {
+      int ready_threads = ready_cnt + (curr != idle_thread);
+      fixed_t twice_load;
+
+      load_avg = (fp_mul (fp_div (fp_from_int (59), fp_from_int (60)),
+                          load_avg)
+                  + fp_from_int (ready_threads) / 60);
+      twice_load = 2 * load_avg;
+      decay_history[mlfqs_seconds % DECAY_HISTORY]
+        = fp_div (twice_load, fp_add_int (twice_load, 1));
+      mlfqs_seconds++;
+    }
+
+  /* Between seconds only the running thread's recent_cpu
+     changes, so its priority is the only one that needs
+     recomputing every fourth tick. */
+  if (now % 4 == 0 && mlfqs_managed (curr))
+    mlfqs_refresh (curr);
+
+  /* Bring a few more threads up to date. */
+  for (i = 0; i < SWEEP_BATCH && !list_empty (&all_list); i++) 
+    {
+      struct thread *t;
+
+      if (sweep_cursor == list_end (&all_list))
+        sweep_cursor = list_begin (&all_list);
+      t = list_entry (sweep_cursor, struct thread, allelem);
+      sweep_cursor = list_next (sweep_cursor);
+      if (mlfqs_managed (t))
+        mlfqs_refresh (t);
+    }
+
+  if (!deadline_active (curr) && ready_max_priority () > curr->priority)
+    intr_yield_on_return ();
+}
+
+/* Applies to T's recent_cpu the decay for every second since it
+   was last brought up to date.  Interrupts must be off. */
+static void
+mlfqs_catch_up (struct thread *t) 
+{
+  ASSERT (intr_get_level () == INTR_OFF);
+
+  /* Coefficients more than DECAY_HISTORY seconds old have been
+     overwritten.  The sweep in mlfqs_tick() visits every thread
+     long before that unless there are tens of thousands of
+     them; if it does happen, skip the oldest seconds. */
+  if (mlfqs_seconds - t->recent_cpu_epoch > DECAY_HISTORY)
+    t->recent_cpu_epoch = mlfqs_seconds - DECAY_HISTORY;
+
+  for (; t->recent_cpu_epoch < mlfqs_seconds; t->recent_cpu_epoch++)
+    t->recent_cpu = fp_add_int (fp_mul (decay_history[t->recent_cpu_epoch
+                                                      % DECAY_HISTORY],
+                                        t->recent_cpu),
+                                t->nice);
+}
+
+/* Brings T's recent_cpu and priority up to date.  Interrupts
+   must be off. */
+static void
+mlfqs_refresh (struct thread *t) 
+{
+  int priority;
+
+  mlfqs_catch_up (t);
+  priority = mlfqs_priority (t);
+  if (priority != t->priority) 
+    change_priority (t, priority);
+}
+
+/* Returns the priority that the multi-level feedback queue
+   scheduler assigns to T, given its up-to-date recent_cpu. */
+static int
+mlfqs_priority (const struct thread *t) 
+{
+  int priority = PRI_MAX - fp_trunc (t->recent_cpu / 4) - t->nice * 2;
+
+  if (priority < PRI_MIN)
+    priority = PRI_MIN;
+  else if (priority > PRI_MAX)
+    priority = PRI_MAX;
+  return priority;
 }
 
 /* Completes a thread switch by activating the new thread's page
@@ -515,7 +1344,7 @@ schedule_tail (struct thread *prev)
   if (prev != NULL && prev->status == THREAD_DYING && prev != initial_thread) 
     {
       ASSERT (prev != curr);
-      palloc_free_page (prev);
+      thread_page_free (prev);
     }
 }
 
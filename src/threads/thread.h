@@ -2,8 +2,12 @@
 #define THREADS_THREAD_H
 
 #include <debug.h>
+#include <heap.h>
 #include <list.h>
 #include <stdint.h>
+#include "threads/fixed-point.h"
+#include "threads/malloc.h"
+#include "devices/timer.h"
 
 /* States in a thread's life cycle. */
 enum thread_status
@@ -24,6 +28,16 @@ typedef int tid_t;
 #define PRI_DEFAULT 31                  /* Default priority. */
 #define PRI_MAX 63                      /* Highest priority. */
 
+/* Thread niceness, for the multi-level feedback queue scheduler. */
+#define NICE_MIN -20                    /* Nicest to other threads. */
+#define NICE_DEFAULT 0                  /* Default niceness. */
+#define NICE_MAX 20                     /* Least nice to other threads. */
+
+/* Thread tickets, for the stride scheduler. */
+#define TICKETS_MIN 1                   /* Smallest share of the CPU. */
+#define TICKETS_DEFAULT 100             /* Default share of the CPU. */
+#define TICKETS_MAX 1000                /* Largest share of the CPU. */
+
 /* A kernel thread or user process.
 
    Each thread structure is stored in its own 4 kB page.  The
@@ -74,12 +88,17 @@ typedef int tid_t;
    the `magic' member of the running thread's `struct thread' is
    set to THREAD_MAGIC.  Stack overflow will normally change this
    value, triggering the assertion. */
-/* The `elem' member has a dual purpose.  It can be an element in
-   the run queue (thread.c), or it can be an element in a
-   semaphore wait list (synch.c).  It can be used these two ways
-   only because they are mutually exclusive: only a thread in the
-   ready state is on the run queue, whereas only a thread in the
-   blocked state is on a semaphore wait list. */
+/* The `elem' member is an element in a run queue (thread.c).
+
+   The `heap_elem' member is shared by every heap that orders
+   threads by some key: the timer's queue of sleeping threads
+   (devices/timer.c), the stride scheduler's and deadline
+   class's run queues (thread.c), and semaphore wait queues
+   (synch.c).  It can be used these ways only because they are
+   mutually exclusive: only a thread in the ready state is on a
+   run queue, whereas only a thread in the blocked state is
+   sleeping or waiting on a semaphore, and it cannot do both at
+   once. */
 struct thread
   {
     /* Owned by thread.c. */
@@ -87,15 +106,55 @@ struct thread
     enum thread_status status;          /* Thread state. */
     char name[16];                      /* Name (for debugging purposes). */
     uint8_t *stack;                     /* Saved stack pointer. */
-    int priority;                       /* Priority. */
+    int priority;                       /* Effective priority. */
+    int base_priority;                  /* Priority before donation. */
+    struct list_elem allelem;           /* List element for all threads list. */
+
+    /* Owned by thread.c, for the multi-level feedback queue
+       scheduler. */
+    int nice;                           /* Niceness. */
+    fixed_t recent_cpu;                 /* Recent CPU usage. */
+    int64_t recent_cpu_epoch;           /* Second recent_cpu is up to date for. */
+
+    /* Owned by thread.c, for the stride scheduler. */
+    int tickets;                        /* Share of the CPU. */
+    int stride;                         /* Pass increment per tick run. */
+    int64_t pass;                       /* Virtual time; least runs next. */
+
+    /* Owned by thread.c, for the deadline scheduling class. */
+    int64_t dl_runtime;                 /* Ticks reserved per period. */
+    int64_t dl_period;                  /* Period in ticks, 0 if not in class. */
+    int64_t dl_deadline;                /* End of current period. */
+    int64_t dl_budget;                  /* Ticks left in current period. */
+    fixed_t dl_util;                    /* dl_runtime / dl_period. */
+    struct timeout dl_timeout;          /* Replenishes budget. */
 
     /* Shared between thread.c and synch.c. */
     struct list_elem elem;              /* List element. */
+    struct semaphore *wait_sema;        /* Semaphore waited on, or null. */
+    struct condition *wait_cond;        /* Condition waited on, or null. */
+    int64_t wait_seq;                   /* Orders equal-priority waiters. */
+    struct lock *waiting_lock;          /* Lock waited on, or null. */
+    struct list held_locks;             /* Locks held. */
+
+    /* Shared between thread.c and devices/timer.c. */
+    struct heap_elem heap_elem;         /* Heap element. */
+    int64_t wakeup_tick;                /* Tick to wake up at if sleeping. */
+
+    /* Owned by threads/malloc.c. */
+    struct magazine magazines[MAGAZINE_CLASS_CNT]; /* Free blocks. */
 
 #ifdef USERPROG
     /* Owned by userprog/process.c. */
     uint32_t *pagedir;                  /* Page directory. */
 #endif
+#ifdef VM
+    /* Owned by userprog/process.c. */
+    struct file *executable;            /* Kept open for paging. */
+
+    /* Owned by vm/page.c. */
+    struct hash *pages;                 /* Supplemental page table. */
+#endif
 
     /* Owned by thread.c. */
     unsigned magic;                     /* Detects stack overflow. */
@@ -106,6 +165,10 @@ struct thread
    Controlled by kernel command-line option "-o mlfqs". */
 extern bool thread_mlfqs;
 
+/* If true, use stride scheduler.
+   Controlled by kernel command-line option "-stride". */
+extern bool thread_stride;
+
 void thread_init (void);
 void thread_start (void);
 
@@ -127,10 +190,20 @@ void thread_yield (void);
 
 int thread_get_priority (void);
 void thread_set_priority (int);
+void thread_donate_priority (struct thread *, int);
+void thread_update_priority (struct thread *);
+void thread_yield_if_outranked (void);
 
 int thread_get_nice (void);
 void thread_set_nice (int);
 int thread_get_recent_cpu (void);
 int thread_get_load_avg (void);
 
+int thread_get_tickets (void);
+void thread_set_tickets (int);
+
+bool thread_set_deadline (int64_t runtime, int64_t period);
+void thread_clear_deadline (void);
+bool thread_preempts (const struct thread *);
+
 #endif /* threads/thread.h */
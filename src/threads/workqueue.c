@@ -0,0 +1,205 @@
+#include "threads/workqueue.h"
+#include <debug.h>
+#include <list.h>
+#include <stdio.h>
+#include <string.h>
+#include "threads/interrupt.h"
+#include "threads/malloc.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+
+/* Deferred work.
+
+   A work queue runs functions, submitted from thread or
+   interrupt context, in a small pool of kernel threads.
+   Submission must not sleep or allocate memory, so each queue
+   holds its pending items in a fixed-size ring buffer protected
+   by disabling interrupts, and submission fails if the ring is
+   full.
+
+   Waking a worker costs a context switch, so submitters wake one
+   only when no wakeup is already outstanding, and a worker that
+   wakes takes up to WORK_BATCH items at a time.  If it leaves
+   items behind, it wakes another worker, which may be itself, to
+   take the next batch. */
+
+#define WORK_RING_SIZE 64       /* Pending items per queue. */
+#define WORK_BATCH 8            /* Items taken per wakeup. */
+
+/* A pending work item. */
+struct work 
+  {
+    work_func *func;            /* Function to call. */
+    void *aux;                  /* Auxiliary data for FUNC. */
+  };
+
+/* A work queue. */
+struct work_queue 
+  {
+    struct list_elem elem;      /* Element in queue_list. */
+    const char *name;           /* Name, for statistics. */
+    struct work ring[WORK_RING_SIZE]; /* Pending items. */
+    unsigned head;              /* Next slot to fill, mod WORK_RING_SIZE. */
+    unsigned tail;              /* Next slot to run, mod WORK_RING_SIZE. */
+    struct semaphore wakeup;    /* Upped to wake a worker. */
+    bool kicked;                /* Wakeup outstanding? */
+
+    /* Statistics. */
+    long long submit_cnt;       /* Items submitted. */
+    long long overflow_cnt;     /* Items refused because ring was full. */
+    long long batch_cnt;        /* Batches taken by workers. */
+  };
+
+/* All work queues, for statistics. */
+static struct list queue_list;
+
+/* The system work queue used by work_submit(). */
+static struct work_queue *system_queue;
+
+static void worker (void *wq_);
+
+/* Initializes the work queue module and creates the system work
+   queue.  Must be called after thread_start(). */
+void
+workqueue_init (void) 
+{
+  list_init (&queue_list);
+  system_queue = work_queue_create ("system", 2, PRI_DEFAULT);
+  if (system_queue == NULL)
+    PANIC ("could not create system work queue");
+}
+
+/* Creates and returns a work queue named NAME, serviced by
+   THREAD_CNT worker threads of the given PRIORITY.  Returns a
+   null pointer if memory for the queue cannot be allocated.  A
+   work queue, and its workers, last until the system shuts
+   down. */
+struct work_queue *
+work_queue_create (const char *name, int thread_cnt, int priority) 
+{
+  struct work_queue *wq;
+  enum intr_level old_level;
+  int i;
+
+  ASSERT (name != NULL);
+  ASSERT (thread_cnt > 0);
+
+  wq = malloc (sizeof *wq);
+  if (wq == NULL)
+    return NULL;
+  wq->name = name;
+  wq->head = wq->tail = 0;
+  sema_init (&wq->wakeup, 0);
+  wq->kicked = false;
+  wq->submit_cnt = wq->overflow_cnt = wq->batch_cnt = 0;
+
+  old_level = intr_disable ();
+  list_push_back (&queue_list, &wq->elem);
+  intr_set_level (old_level);
+
+  for (i = 0; i < thread_cnt; i++) 
+    {
+      char thread_name[16];
+      snprintf (thread_name, sizeof thread_name, "%s/%d", name, i);
+      if (thread_create (thread_name, priority, worker, wq) == TID_ERROR)
+        PANIC ("could not create worker %d for work queue %s", i, name);
+    }
+
+  return wq;
+}
+
+/* Queues FUNC to be called with AUX by one of WQ's workers.
+   Returns true if successful, false if WQ's ring of pending
+   items is full.
+
+   This function may be called from an interrupt handler. */
+bool
+work_queue_submit (struct work_queue *wq, work_func *func, void *aux) 
+{
+  enum intr_level old_level;
+  struct work *w;
+  bool kick;
+
+  ASSERT (wq != NULL);
+  ASSERT (func != NULL);
+
+  old_level = intr_disable ();
+  if (wq->head - wq->tail >= WORK_RING_SIZE) 
+    {
+      wq->overflow_cnt++;
+      intr_set_level (old_level);
+      return false;
+    }
+  w = &wq->ring[wq->head++ % WORK_RING_SIZE];
+  w->func = func;
+  w->aux = aux;
+  wq->submit_cnt++;
+  kick = !wq->kicked;
+  wq->kicked = true;
+  intr_set_level (old_level);
+
+  /* Outside the critical section, so that we yield to the
+     worker if it outranks us. */
+  if (kick)
+    sema_up (&wq->wakeup);
+  return true;
+}
+
+/* Queues FUNC to be called with AUX on the system work queue.
+   Returns true if successful, false if the queue is full or has
+   not yet been created.
+
+   This function may be called from an interrupt handler. */
+bool
+work_submit (work_func *func, void *aux) 
+{
+  return system_queue != NULL && work_queue_submit (system_queue, func, aux);
+}
+
+/* Prints statistics for every work queue. */
+void
+workqueue_print_stats (void) 
+{
+  struct list_elem *e;
+
+  if (system_queue == NULL)
+    return;
+  for (e = list_begin (&queue_list); e != list_end (&queue_list);
+       e = list_next (e))
+    {
+      struct work_queue *wq = list_entry (e, struct work_queue, elem);
+      printf ("Work queue %s: %lld items in %lld batches, %lld overflows\n",
+              wq->name, wq->submit_cnt, wq->batch_cnt, wq->overflow_cnt);
+    }
+}
+
+/* Worker thread for work queue WQ_.  Runs pending items in
+   batches, forever. */
+static void
+worker (void *wq_) 
+{
+  struct work_queue *wq = wq_;
+
+  for (;;) 
+    {
+      struct work batch[WORK_BATCH];
+      enum intr_level old_level;
+      int cnt, i;
+
+      sema_down (&wq->wakeup);
+
+      old_level = intr_disable ();
+      for (cnt = 0; cnt < WORK_BATCH && wq->tail != wq->head; cnt++)
+        batch[cnt] = wq->ring[wq->tail++ % WORK_RING_SIZE];
+      if (wq->tail != wq->head)
+        sema_up (&wq->wakeup);
+      else
+        wq->kicked = false;
+      if (cnt > 0)
+        wq->batch_cnt++;
+      intr_set_level (old_level);
+
+      for (i = 0; i < cnt; i++)
+        batch[i].func (batch[i].aux);
+    }
+}
@@ -0,0 +1,19 @@
+#ifndef THREADS_WORKQUEUE_H
+#define THREADS_WORKQUEUE_H
+
+#include <stdbool.h>
+
+/* A function run by a work queue's worker thread, in thread
+   context, so unlike a timeout function it may sleep. */
+typedef void work_func (void *aux);
+
+struct work_queue;
+
+void workqueue_init (void);
+struct work_queue *work_queue_create (const char *name, int thread_cnt,
+                                      int priority);
+bool work_queue_submit (struct work_queue *, work_func *, void *aux);
+bool work_submit (work_func *, void *aux);
+void workqueue_print_stats (void);
+
+#endif /* threads/workqueue.h */
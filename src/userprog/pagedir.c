@@ -2,12 +2,18 @@
 #include <stdbool.h>
 #include <stddef.h>
 #include <string.h>
+#include "threads/cpu.h"
 #include "threads/init.h"
 #include "threads/pte.h"
 #include "threads/palloc.h"
 
+/* Invalidating more pages than this at once flushes the whole
+   TLB instead of invalidating the pages one by one. */
+#define INVLPG_MAX 32
+
 static uint32_t *active_pd (void);
 static void invalidate_pagedir (uint32_t *);
+static void invalidate_page (uint32_t *, const void *);
 
 /* Creates a new page directory that has mappings for kernel
    virtual addresses, but none for user virtual addresses.
@@ -154,8 +160,54 @@ pagedir_clear_page (uint32_t *pd, void *upage)
   if (pte != NULL && (*pte & PTE_P) != 0)
     {
       *pte &= ~PTE_P;
-      invalidate_pagedir (pd);
+      invalidate_page (pd, upage);
+    }
+}
+
+/* Marks the PAGE_CNT user virtual pages starting at UPAGE "not
+   present" in page directory PD, as pagedir_clear_page() does
+   for each of them.  The TLB is invalidated once for the whole
+   range: page by page for a short range, or by flushing it
+   entirely for a long one.  Returns the number of
+   pages that were mapped.
+   The pages need not be mapped. */
+size_t
+pagedir_clear_range (uint32_t *pd, void *upage, size_t page_cnt) 
+{
+  uint8_t *start = upage;
+  uint8_t *end = start + page_cnt * PGSIZE;
+  uint8_t *page;
+  size_t cleared_cnt = 0;
+
+  ASSERT (pg_ofs (upage) == 0);
+  ASSERT (is_user_vaddr (upage));
+  ASSERT (page_cnt <= (size_t) ((uint8_t *) PHYS_BASE - start) / PGSIZE);
+
+  for (page = start; page < end; page += PGSIZE)
+    {
+      uint32_t *pte = lookup_page (pd, page, false);
+      if (pte == NULL)
+        {
+          /* No page table here, so skip to the next one. */
+          page += PTSPAN - ((uintptr_t) page & (PTSPAN - 1)) - PGSIZE;
+          continue;
+        }
+      if ((*pte & PTE_P) != 0)
+        {
+          *pte &= ~PTE_P;
+          cleared_cnt++;
+        }
     }
+
+  if (cleared_cnt == 0)
+    return 0;
+  if (page_cnt > INVLPG_MAX)
+    invalidate_pagedir (pd);
+  else if (active_pd () == pd)
+    for (page = start; page < end; page += PGSIZE)
+      cpu_invlpg (page);
+
+  return cleared_cnt;
 }
 
 /* Returns true if the PTE for virtual page VPAGE in PD is dirty,
@@ -170,7 +222,9 @@ pagedir_is_dirty (uint32_t *pd, const void *vpage)
 }
 
 /* Set the dirty bit to DIRTY in the PTE for virtual page VPAGE
-   in PD. */
+   in PD.  Clearing a bit that is already clear needs no TLB
+   invalidation, because the CPU sets the bit in the PTE before
+   it caches a translation that relies on it. */
 void
 pagedir_set_dirty (uint32_t *pd, const void *vpage, bool dirty) 
 {
@@ -179,10 +233,10 @@ pagedir_set_dirty (uint32_t *pd, const void *vpage, bool dirty)
     {
       if (dirty)
         *pte |= PTE_D;
-      else 
+      else if ((*pte & PTE_D) != 0)
         {
           *pte &= ~(uint32_t) PTE_D;
-          invalidate_pagedir (pd);
+          invalidate_page (pd, vpage);
         }
     }
 }
@@ -199,7 +253,8 @@ pagedir_is_accessed (uint32_t *pd, const void *vpage)
 }
 
 /* Sets the accessed bit to ACCESSED in the PTE for virtual page
-   VPAGE in PD. */
+   VPAGE in PD.  As with pagedir_set_dirty(), clearing a bit that
+   is already clear needs no TLB invalidation. */
 void
 pagedir_set_accessed (uint32_t *pd, const void *vpage, bool accessed) 
 {
@@ -208,10 +263,10 @@ pagedir_set_accessed (uint32_t *pd, const void *vpage, bool accessed)
     {
       if (accessed)
         *pte |= PTE_A;
-      else 
+      else if ((*pte & PTE_A) != 0)
         {
           *pte &= ~(uint32_t) PTE_A; 
-          invalidate_pagedir (pd);
+          invalidate_page (pd, vpage);
         }
     }
 }
@@ -263,3 +318,13 @@ invalidate_pagedir (uint32_t *pd)
       pagedir_activate (pd);
     } 
 }
+
+/* Like invalidate_pagedir(), but invalidates only the TLB entry
+   for virtual page VPAGE, with INVLPG, leaving the rest of the
+   TLB alone. */
+static void
+invalidate_page (uint32_t *pd, const void *vpage) 
+{
+  if (active_pd () == pd)
+    cpu_invlpg (vpage);
+}
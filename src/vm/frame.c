@@ -0,0 +1,342 @@
+#include "vm/frame.h"
+#include <debug.h>
+#include <stdio.h>
+#include <string.h>
+#include "threads/slab.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "threads/vaddr.h"
+#include "userprog/pagedir.h"
+#include "threads/interrupt.h"
+#include "vm/page.h"
+#include "vm/swap.h"
+
+/* Most frames that frame_reclaim() evicts in one call. */
+#define RECLAIM_MAX 16
+
+/* Frames that frame_alloc() evicts at once when user memory is
+   exhausted.  Evicting several frames together lets their dirty
+   pages be written to swap in a single cluster. */
+#define EVICT_BATCH SWAP_CLUSTER_MAX
+
+/* Frame table: all the frames that hold user pages, in clock
+   order.  The clock hand points to the next frame to consider
+   for eviction, or is null if the table is empty. */
+static struct list frames;
+static struct list_elem *hand;
+static size_t frame_cnt;
+
+/* Protects the frame table, the clock hand, and the `frame',
+   `swap_slot', and `evicting' members of every struct page that
+   is in memory or being evicted. */
+static struct lock frame_lock;
+
+/* Broadcast, with frame_lock held, whenever evicted pages have
+   been written to swap and their `evicting' members cleared. */
+static struct condition evict_done;
+
+/* Cache of struct frames. */
+static struct kmem_cache *frame_cache;
+
+/* Statistics. */
+static long long evict_cnt;             /* Frames evicted. */
+static long long hand_cnt;              /* Frames the hand passed over. */
+
+static size_t evict_frames (void *kpages[], size_t max, bool swap);
+static struct frame *choose_victim (bool swap, bool *dirty);
+static void remove_frame (struct frame *);
+static size_t frame_reclaim (void);
+
+/* Initializes the frame table. */
+void
+frame_init (void) 
+{
+  list_init (&frames);
+  hand = NULL;
+  lock_init (&frame_lock);
+  cond_init (&evict_done);
+  frame_cache = kmem_cache_create ("frame", sizeof (struct frame), NULL);
+  if (frame_cache == NULL)
+    PANIC ("could not create frame cache");
+  palloc_add_reclaimer (frame_reclaim);
+}
+
+/* Obtains a frame from the user pool, allocated with FLAGS, to
+   hold PAGE for the current process, and makes it PAGE's frame.
+   If user memory is exhausted, evicts other pages to make room,
+   writing them to swap if necessary.  The frame is returned
+   pinned: the caller should fill it in, map it, and then call
+   frame_unpin().
+   Returns a null pointer if no frame is free and none can be
+   evicted. */
+struct frame *
+frame_alloc (struct page *page, enum palloc_flags flags) 
+{
+  struct frame *f;
+  void *kpages[EVICT_BATCH];
+  bool evicted = false;
+
+  ASSERT (!(flags & PAL_USER));
+
+  /* Allocate before taking frame_lock, because allocating can
+     run frame_reclaim(). */
+  f = kmem_cache_alloc (frame_cache);
+  if (f == NULL)
+    return NULL;
+  f->kpage = palloc_get_page (PAL_USER | flags);
+
+  lock_acquire (&frame_lock);
+  if (f->kpage == NULL) 
+    {
+      /* Keep one of the evicted frames, and give the rest back
+         for the faults that are likely to follow. */
+      size_t cnt = evict_frames (kpages, EVICT_BATCH, true);
+      if (cnt > 0) 
+        {
+          f->kpage = kpages[0];
+          while (cnt > 1)
+            palloc_free_page (kpages[--cnt]);
+          evicted = true;
+        }
+    }
+  if (f->kpage == NULL) 
+    {
+      lock_release (&frame_lock);
+      kmem_cache_free (frame_cache, f);
+      return NULL;
+    }
+
+  /* Another process's eviction may be writing PAGE to swap,
+     in which case the caller must not read it back until it
+     has been written. */
+  while (page->evicting)
+    cond_wait (&evict_done, &frame_lock);
+
+  f->owner = thread_current ();
+  f->page = page;
+  f->pinned = true;
+  page->frame = f;
+
+  /* Insert just behind the hand, so that the new frame is the
+     last one the hand reaches. */
+  if (hand == NULL) 
+    {
+      list_push_back (&frames, &f->elem);
+      hand = &f->elem;
+    }
+  else
+    list_insert (hand, &f->elem);
+  frame_cnt++;
+  lock_release (&frame_lock);
+
+  if (evicted && (flags & PAL_ZERO))
+    memset (f->kpage, 0, PGSIZE);
+  return f;
+}
+
+/* Allows F to be evicted. */
+void
+frame_unpin (struct frame *f) 
+{
+  lock_acquire (&frame_lock);
+  ASSERT (f->pinned);
+  f->pinned = false;
+  lock_release (&frame_lock);
+}
+
+/* If PAGE, a page of the current process, is in a frame,
+   unmaps it and frees the frame.  If PAGE is being written to
+   swap, waits until it has been, so that afterward PAGE's
+   `swap_slot' tells whether it has a swap slot to free. */
+void
+frame_free_page (struct page *page) 
+{
+  struct frame *f;
+
+  lock_acquire (&frame_lock);
+  while (page->evicting)
+    cond_wait (&evict_done, &frame_lock);
+  f = page->frame;
+  if (f != NULL) 
+    {
+      ASSERT (f->owner == thread_current ());
+      pagedir_clear_page (f->owner->pagedir, page->upage);
+      page->frame = NULL;
+      remove_frame (f);
+      palloc_free_page (f->kpage);
+      kmem_cache_free (frame_cache, f);
+    }
+  lock_release (&frame_lock);
+}
+
+/* Prints frame table statistics. */
+void
+frame_print_stats (void) 
+{
+  printf ("Frame: %zu frames in use, %lld evicted, "
+          "%lld passed over by the clock hand\n",
+          frame_cnt, evict_cnt, hand_cnt);
+}
+
+/* Evicts up to MAX frames from the frame table, stores their
+   kernel pages into KPAGES, and returns the number evicted.  If
+   SWAP is true, pages that have been modified are written to
+   swap, all together in one cluster, and may be evicted;
+   otherwise, only unmodified pages, which can simply be dropped,
+   are evicted.
+   Must be called with frame_lock held.  Releases frame_lock
+   while writing to swap, so the frame table may change before
+   this function returns. */
+static size_t
+evict_frames (void *kpages[], size_t max, bool swap) 
+{
+  struct page *dirty_pages[SWAP_CLUSTER_MAX];
+  void *dirty_kpages[SWAP_CLUSTER_MAX];
+  size_t dirty_cnt = 0;
+  swap_slot_t slot = SWAP_SLOT_NONE;
+  size_t slot_cnt = swap ? swap_alloc (SWAP_CLUSTER_MAX, &slot) : 0;
+  size_t cnt = 0;
+  size_t i;
+
+  ASSERT (lock_held_by_current_thread (&frame_lock));
+
+  while (cnt < max) 
+    {
+      bool dirty;
+      struct frame *f = choose_victim (dirty_cnt < slot_cnt, &dirty);
+      if (f == NULL)
+        break;
+
+      if (dirty) 
+        {
+          f->page->evicting = true;
+          dirty_pages[dirty_cnt] = f->page;
+          dirty_kpages[dirty_cnt] = f->kpage;
+          dirty_cnt++;
+        }
+      f->page->frame = NULL;
+      kpages[cnt++] = f->kpage;
+      remove_frame (f);
+      kmem_cache_free (frame_cache, f);
+    }
+
+  /* The victims are already unmapped and out of the frame
+     table, so neither their owners nor other evictions can touch
+     them while they are written out, and we need not hold
+     frame_lock for the write.  An owner that faults on one of
+     them, or exits, waits until its `evicting' is cleared. */
+  if (dirty_cnt > 0) 
+    {
+      lock_release (&frame_lock);
+      swap_out (slot, dirty_kpages, dirty_cnt);
+      lock_acquire (&frame_lock);
+      for (i = 0; i < dirty_cnt; i++) 
+        {
+          dirty_pages[i]->swap_slot = slot + i;
+          dirty_pages[i]->evicting = false;
+        }
+      cond_broadcast (&evict_done, &frame_lock);
+    }
+  if (slot_cnt > dirty_cnt)
+    swap_free (slot + dirty_cnt, slot_cnt - dirty_cnt);
+
+  evict_cnt += cnt;
+  return cnt;
+}
+
+/* Chooses a frame to evict with the clock algorithm, unmaps its
+   page, and returns it, still in the frame table.  Sets *DIRTY
+   to true if the page was modified, in which case it must be
+   written to swap before its frame is reused.
+
+   The hand sweeps the frame table, clearing the accessed bit of
+   each recently used page that it passes, and stops at the first
+   frame whose page has not been used since the hand last came
+   by.  Pinned frames are skipped, as are frames with modified
+   pages unless SWAP is true.  Two full sweeps always suffice, so
+   that the amortized cost of an eviction is constant.
+   Returns a null pointer if no frame can be evicted.
+   Must be called with frame_lock held. */
+static struct frame *
+choose_victim (bool swap, bool *dirty) 
+{
+  size_t i;
+
+  ASSERT (lock_held_by_current_thread (&frame_lock));
+
+  for (i = 0; i < 2 * frame_cnt; i++) 
+    {
+      struct frame *f = list_entry (hand, struct frame, elem);
+      uint32_t *pd = f->owner->pagedir;
+      void *upage = f->page->upage;
+      enum intr_level old_level;
+
+      hand = list_next (hand);
+      if (hand == list_end (&frames))
+        hand = list_begin (&frames);
+      hand_cnt++;
+
+      if (f->pinned)
+        continue;
+      if (pagedir_is_accessed (pd, upage)) 
+        {
+          pagedir_set_accessed (pd, upage, false);
+          continue;
+        }
+
+      /* The owner must not modify the page between our checking
+         its dirty bit and unmapping it. */
+      old_level = intr_disable ();
+      *dirty = pagedir_is_dirty (pd, upage);
+      if (!*dirty || swap) 
+        {
+          pagedir_clear_page (pd, upage);
+          intr_set_level (old_level);
+          return f;
+        }
+      intr_set_level (old_level);
+    }
+  return NULL;
+}
+
+/* Removes F from the frame table, moving the hand off of it if
+   necessary.  Must be called with frame_lock held. */
+static void
+remove_frame (struct frame *f) 
+{
+  if (hand == &f->elem) 
+    {
+      hand = list_next (hand);
+      if (hand == list_end (&frames))
+        hand = list_begin (&frames);
+    }
+  list_remove (&f->elem);
+  if (list_empty (&frames))
+    hand = NULL;
+  frame_cnt--;
+}
+
+/* Page allocator reclaimer.  Evicts up to RECLAIM_MAX user
+   pages that have not been used recently, so that the kernel
+   can have their frames, and returns the number freed.  Gives
+   up at once if the frame table is busy, because the caller
+   may be in the middle of using it.  Evicts only unmodified
+   pages, because the caller may not be able to wait for swap. */
+static size_t
+frame_reclaim (void) 
+{
+  void *kpages[RECLAIM_MAX];
+  size_t freed_cnt;
+  size_t i;
+
+  if (lock_held_by_current_thread (&frame_lock)
+      || !lock_try_acquire (&frame_lock))
+    return 0;
+
+  freed_cnt = evict_frames (kpages, RECLAIM_MAX, false);
+  lock_release (&frame_lock);
+
+  for (i = 0; i < freed_cnt; i++)
+    palloc_free_page (kpages[i]);
+  return freed_cnt;
+}
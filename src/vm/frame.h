@@ -0,0 +1,32 @@
+#ifndef VM_FRAME_H
+#define VM_FRAME_H
+
+#include <list.h>
+#include <stdbool.h>
+#include "threads/palloc.h"
+
+struct page;
+
+/* A frame of physical memory that holds a user page.
+
+   Every frame in the frame table is on a circular list that the
+   clock hand sweeps to choose a frame to evict when user memory
+   runs out.  A pinned frame is never evicted; frame_alloc()
+   returns frames pinned so that they are not evicted before
+   they have been filled in and mapped. */
+struct frame
+  {
+    struct list_elem elem;              /* Element in frame table. */
+    void *kpage;                        /* Kernel virtual address. */
+    struct thread *owner;               /* Process that maps it. */
+    struct page *page;                  /* Page that it holds. */
+    bool pinned;                        /* Never evicted if true. */
+  };
+
+void frame_init (void);
+struct frame *frame_alloc (struct page *, enum palloc_flags);
+void frame_unpin (struct frame *);
+void frame_free_page (struct page *);
+void frame_print_stats (void);
+
+#endif /* vm/frame.h */
@@ -0,0 +1,259 @@
+#include "vm/page.h"
+#include <debug.h>
+#include <stdio.h>
+#include <string.h>
+#include "filesys/file.h"
+#include "threads/malloc.h"
+#include "threads/palloc.h"
+#include "threads/slab.h"
+#include "threads/thread.h"
+#include "threads/vaddr.h"
+#include "userprog/pagedir.h"
+#include "vm/frame.h"
+#include "vm/swap.h"
+
+/* Cache of struct pages. */
+static struct kmem_cache *page_cache;
+
+/* Statistics. */
+static long long file_load_cnt;         /* Pages read from files. */
+static long long zero_load_cnt;         /* Pages zero-filled. */
+
+static hash_hash_func page_hash;
+static hash_less_func page_less;
+static void page_destroy (struct hash_elem *, void *aux);
+static bool page_add (struct page *);
+
+/* Initializes the page module. */
+void
+page_init (void) 
+{
+  page_cache = kmem_cache_create ("page", sizeof (struct page), NULL);
+  if (page_cache == NULL)
+    PANIC ("could not create page cache");
+}
+
+/* Creates an empty supplemental page table for the current
+   process.  Returns true if successful, false if memory
+   allocation fails. */
+bool
+page_table_create (void) 
+{
+  struct thread *t = thread_current ();
+
+  ASSERT (t->pages == NULL);
+
+  t->pages = malloc (sizeof *t->pages);
+  if (t->pages == NULL)
+    return false;
+  if (!hash_init (t->pages, page_hash, page_less, NULL)) 
+    {
+      free (t->pages);
+      t->pages = NULL;
+      return false;
+    }
+  return true;
+}
+
+/* Destroys the current process's supplemental page table, if it
+   has one, and frees the frames and swap slots that its pages
+   occupy.  Must be
+   called before the process's page directory is destroyed. */
+void
+page_table_destroy (void) 
+{
+  struct thread *t = thread_current ();
+
+  if (t->pages != NULL) 
+    {
+      /* Unmap every user page at once, so that the TLB is
+         flushed once for the whole address space instead of
+         once for each page as its frame is freed. */
+      if (t->pagedir != NULL)
+        pagedir_clear_range (t->pagedir, NULL,
+                             (uintptr_t) PHYS_BASE / PGSIZE);
+      hash_destroy (t->pages, page_destroy);
+      free (t->pages);
+      t->pages = NULL;
+    }
+}
+
+/* Records that user page UPAGE of the current process is to be
+   filled with READ_BYTES bytes read from FILE at offset OFS,
+   followed by zeros, when it is first accessed.  The page is
+   read-only unless WRITABLE is true.  FILE must stay open for as
+   long as the process runs.
+   Returns true if successful, false if UPAGE is already in the
+   page table or if memory allocation fails. */
+bool
+page_add_file (void *upage, struct file *file, off_t ofs,
+               size_t read_bytes, bool writable) 
+{
+  struct page *p;
+
+  ASSERT (pg_ofs (upage) == 0);
+  ASSERT (is_user_vaddr (upage));
+  ASSERT (read_bytes <= PGSIZE);
+
+  p = kmem_cache_alloc (page_cache);
+  if (p == NULL)
+    return false;
+  p->upage = upage;
+  p->writable = writable;
+  p->frame = NULL;
+  p->swap_slot = SWAP_SLOT_NONE;
+  p->evicting = false;
+  p->file = read_bytes > 0 ? file : NULL;
+  p->ofs = ofs;
+  p->read_bytes = read_bytes;
+  return page_add (p);
+}
+
+/* Records that user page UPAGE of the current process is to be
+   zeroed when it is first accessed.  The page is read-only
+   unless WRITABLE is true.
+   Returns true if successful, false if UPAGE is already in the
+   page table or if memory allocation fails. */
+bool
+page_add_zero (void *upage, bool writable) 
+{
+  return page_add_file (upage, NULL, 0, 0, writable);
+}
+
+/* Returns the page in the current process's page table that
+   contains user virtual address UPAGE, or a null pointer if
+   there is none. */
+struct page *
+page_lookup (const void *upage) 
+{
+  struct thread *t = thread_current ();
+  struct page p;
+  struct hash_elem *e;
+
+  if (t->pages == NULL)
+    return NULL;
+
+  p.upage = pg_round_down (upage);
+  e = hash_find (t->pages, &p.hash_elem);
+  return e != NULL ? hash_entry (e, struct page, hash_elem) : NULL;
+}
+
+/* Brings in the page that contains FAULT_ADDR, which the current
+   process has touched for the first time, and maps it.
+   Returns true if successful, false if FAULT_ADDR is not in any
+   page of the process or if the page cannot be loaded, in which
+   case the fault is a genuine one. */
+bool
+page_load (const void *fault_addr) 
+{
+  struct thread *t = thread_current ();
+  struct page *p;
+  struct frame *f;
+  uint8_t *kpage;
+  swap_slot_t swap_slot;
+
+  if (!is_user_vaddr (fault_addr))
+    return false;
+  p = page_lookup (fault_addr);
+  if (p == NULL || pagedir_get_page (t->pagedir, p->upage) != NULL)
+    return false;
+
+  f = frame_alloc (p, (p->swap_slot == SWAP_SLOT_NONE && p->read_bytes == 0
+                       ? PAL_ZERO : 0));
+  if (f == NULL)
+    return false;
+  kpage = f->kpage;
+
+  /* frame_alloc() waits for an eviction that was writing P to
+     swap to finish, so P's swap slot is up to date. */
+  swap_slot = p->swap_slot;
+  if (swap_slot != SWAP_SLOT_NONE)
+    swap_in (swap_slot, kpage);
+  else if (p->read_bytes == 0)
+    zero_load_cnt++;
+  else 
+    {
+      if (file_read_at (p->file, kpage, p->read_bytes, p->ofs)
+          != (off_t) p->read_bytes) 
+        {
+          frame_free_page (p);
+          return false;
+        }
+      memset (kpage + p->read_bytes, 0, PGSIZE - p->read_bytes);
+      file_load_cnt++;
+    }
+
+  if (!pagedir_set_page (t->pagedir, p->upage, kpage, p->writable)) 
+    {
+      frame_free_page (p);
+      return false;
+    }
+
+  /* The page no longer matches its file, or is no longer all
+     zeros, so it must go back to swap if it is evicted again,
+     even if it is not modified in the meantime. */
+  if (swap_slot != SWAP_SLOT_NONE) 
+    {
+      pagedir_set_dirty (t->pagedir, p->upage, true);
+      p->swap_slot = SWAP_SLOT_NONE;
+      swap_free (swap_slot, 1);
+    }
+  frame_unpin (f);
+  return true;
+}
+
+/* Prints paging statistics. */
+void
+page_print_stats (void) 
+{
+  printf ("Paging: %lld pages read from files, %lld pages zeroed\n",
+          file_load_cnt, zero_load_cnt);
+}
+
+/* Adds P to the current process's page table, or frees it and
+   returns false if its page is already there. */
+static bool
+page_add (struct page *p) 
+{
+  struct thread *t = thread_current ();
+
+  ASSERT (t->pages != NULL);
+
+  if (hash_insert (t->pages, &p->hash_elem) != NULL) 
+    {
+      kmem_cache_free (page_cache, p);
+      return false;
+    }
+  return true;
+}
+
+/* Returns a hash value for the page that E refers to. */
+static unsigned
+page_hash (const struct hash_elem *e, void *aux UNUSED) 
+{
+  const struct page *p = hash_entry (e, struct page, hash_elem);
+  return hash_bytes (&p->upage, sizeof p->upage);
+}
+
+/* Returns true if the page that A refers to precedes the page
+   that B refers to. */
+static bool
+page_less (const struct hash_elem *a, const struct hash_elem *b,
+           void *aux UNUSED) 
+{
+  const struct page *pa = hash_entry (a, struct page, hash_elem);
+  const struct page *pb = hash_entry (b, struct page, hash_elem);
+  return pa->upage < pb->upage;
+}
+
+/* Frees the page that E refers to, and its frame or swap slot. */
+static void
+page_destroy (struct hash_elem *e, void *aux UNUSED) 
+{
+  struct page *p = hash_entry (e, struct page, hash_elem);
+
+  frame_free_page (p);
+  if (p->swap_slot != SWAP_SLOT_NONE)
+    swap_free (p->swap_slot, 1);
+  kmem_cache_free (page_cache, p);
+}
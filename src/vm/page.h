@@ -0,0 +1,55 @@
+#ifndef VM_PAGE_H
+#define VM_PAGE_H
+
+#include <hash.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "filesys/off_t.h"
+#include "vm/swap.h"
+
+struct file;
+
+/* A page of a process's virtual address space, as recorded in
+   its supplemental page table.
+
+   The supplemental page table knows how to fill in each page of
+   the process that is not in memory, so that pages can be
+   brought in when the process first touches them instead of all
+   at once when it starts.  A page is filled with READ_BYTES
+   bytes read from FILE at offset OFS, followed by zeros.  A page
+   with READ_BYTES of 0 is simply zeroed.
+
+   A page that is in memory has a frame (see vm/frame.h).  When
+   the frame is evicted, the page is just dropped if it has not
+   been modified, to be filled in again when it is next used.
+   Otherwise, it is written to a swap slot (see vm/swap.h) and
+   read back from there.  While that write is in progress, the
+   page has neither a frame nor a swap slot, and `evicting' is
+   true. */
+struct page
+  {
+    struct hash_elem hash_elem;         /* Element in page table. */
+    void *upage;                        /* User virtual address. */
+    bool writable;                      /* False for read-only pages. */
+    struct frame *frame;                /* Frame, if in memory. */
+    swap_slot_t swap_slot;              /* Swap slot, if swapped out. */
+    bool evicting;                      /* Being written to swap. */
+
+    struct file *file;                  /* File to read from. */
+    off_t ofs;                          /* Offset in FILE. */
+    size_t read_bytes;                  /* Bytes to read, then zero. */
+  };
+
+void page_init (void);
+bool page_table_create (void);
+void page_table_destroy (void);
+
+bool page_add_file (void *upage, struct file *, off_t ofs,
+                    size_t read_bytes, bool writable);
+bool page_add_zero (void *upage, bool writable);
+struct page *page_lookup (const void *upage);
+bool page_load (const void *fault_addr);
+
+void page_print_stats (void);
+
+#endif /* vm/page.h */
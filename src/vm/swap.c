@@ -0,0 +1,153 @@
+#include "vm/swap.h"
+#include <bitmap.h>
+#include <debug.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include "devices/disk.h"
+#include "devices/timer.h"
+#include "threads/synch.h"
+#include "threads/vaddr.h"
+
+/* Swap space.
+
+   Pages are swapped out to the swap disk, hd1:1, which is
+   divided into page-sized slots.  A bitmap records which slots
+   are in use.
+
+   Evicting many dirty pages at once is common, so swap_out()
+   writes a cluster of pages to consecutive slots with a single
+   multi-sector disk command, instead of issuing one command per
+   page or, worse, per sector.  swap_alloc() finds the runs of
+   consecutive slots that this needs. */
+
+/* Sectors per page. */
+#define PAGE_SECTORS (PGSIZE / DISK_SECTOR_SIZE)
+
+/* Swap disk, or a null pointer if there is none. */
+static struct disk *swap_disk;
+
+/* Slots in use. */
+static struct bitmap *used_slots;
+
+/* Protects used_slots and the statistics. */
+static struct lock swap_lock;
+
+/* Statistics. */
+static long long out_cnt;               /* Pages written. */
+static long long out_write_cnt;         /* Write commands issued. */
+static uint64_t out_cycles;             /* Time spent writing. */
+static long long in_cnt;                /* Pages read. */
+static uint64_t in_cycles;              /* Time spent reading. */
+
+/* Initializes the swap disk, if there is one. */
+void
+swap_init (void) 
+{
+  size_t slot_cnt;
+
+  lock_init (&swap_lock);
+  swap_disk = disk_get (1, 1);
+  if (swap_disk == NULL) 
+    {
+      printf ("swap: no swap disk, dirty pages cannot be evicted\n");
+      return;
+    }
+
+  slot_cnt = disk_size (swap_disk) / PAGE_SECTORS;
+  used_slots = bitmap_create (slot_cnt);
+  if (used_slots == NULL)
+    PANIC ("could not allocate swap slot bitmap");
+  printf ("swap: %zu slots on hd1:1\n", slot_cnt);
+}
+
+/* Tries to allocate a run of PAGE_CNT consecutive swap slots.  If
+   there is no run that long, tries shorter runs in turn.  Stores
+   the first slot of the run into *SLOT and returns its length,
+   or returns 0 if swap is full or there is no swap disk. */
+size_t
+swap_alloc (size_t page_cnt, swap_slot_t *slot) 
+{
+  ASSERT (page_cnt > 0);
+
+  if (used_slots == NULL)
+    return 0;
+
+  lock_acquire (&swap_lock);
+  for (; page_cnt > 0; page_cnt--) 
+    {
+      *slot = bitmap_scan_and_flip (used_slots, 0, page_cnt, false);
+      if (*slot != BITMAP_ERROR)
+        break;
+    }
+  lock_release (&swap_lock);
+  return page_cnt;
+}
+
+/* Frees the PAGE_CNT swap slots starting at SLOT. */
+void
+swap_free (swap_slot_t slot, size_t page_cnt) 
+{
+  lock_acquire (&swap_lock);
+  ASSERT (bitmap_all (used_slots, slot, page_cnt));
+  bitmap_set_multiple (used_slots, slot, page_cnt, false);
+  lock_release (&swap_lock);
+}
+
+/* Writes the PAGE_CNT pages in KPAGES to the consecutive swap
+   slots starting at SLOT, which must have been allocated, with a
+   single disk command. */
+void
+swap_out (swap_slot_t slot, void *const kpages[], size_t page_cnt) 
+{
+  const void *sectors[SWAP_CLUSTER_MAX * PAGE_SECTORS];
+  uint64_t start;
+  size_t i;
+
+  ASSERT (page_cnt > 0 && page_cnt <= SWAP_CLUSTER_MAX);
+
+  for (i = 0; i < page_cnt * PAGE_SECTORS; i++)
+    sectors[i] = (uint8_t *) kpages[i / PAGE_SECTORS]
+                 + i % PAGE_SECTORS * DISK_SECTOR_SIZE;
+
+  start = timer_cycles ();
+  disk_writev (swap_disk, slot * PAGE_SECTORS, sectors,
+               page_cnt * PAGE_SECTORS);
+
+  lock_acquire (&swap_lock);
+  out_cycles += timer_cycles () - start;
+  out_cnt += page_cnt;
+  out_write_cnt++;
+  lock_release (&swap_lock);
+}
+
+/* Reads the page in swap slot SLOT into KPAGE. */
+void
+swap_in (swap_slot_t slot, void *kpage) 
+{
+  void *sectors[PAGE_SECTORS];
+  uint64_t start;
+  size_t i;
+
+  for (i = 0; i < PAGE_SECTORS; i++)
+    sectors[i] = (uint8_t *) kpage + i * DISK_SECTOR_SIZE;
+
+  start = timer_cycles ();
+  disk_readv (swap_disk, slot * PAGE_SECTORS, sectors, PAGE_SECTORS);
+
+  lock_acquire (&swap_lock);
+  in_cycles += timer_cycles () - start;
+  in_cnt++;
+  lock_release (&swap_lock);
+}
+
+/* Prints swap statistics. */
+void
+swap_print_stats (void) 
+{
+  printf ("Swap: %lld pages out in %lld writes, %lld pages in\n",
+          out_cnt, out_write_cnt, in_cnt);
+  printf ("Swap: %"PRIu64" cycles per page out, "
+          "%"PRIu64" cycles per page in\n",
+          out_cnt > 0 ? out_cycles / out_cnt : 0,
+          in_cnt > 0 ? in_cycles / in_cnt : 0);
+}
@@ -0,0 +1,23 @@
+#ifndef VM_SWAP_H
+#define VM_SWAP_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/* A page-sized slot on the swap disk. */
+typedef size_t swap_slot_t;
+
+/* Not a swap slot. */
+#define SWAP_SLOT_NONE ((swap_slot_t) -1)
+
+/* Most pages that swap_out() writes with a single command. */
+#define SWAP_CLUSTER_MAX 8
+
+void swap_init (void);
+size_t swap_alloc (size_t page_cnt, swap_slot_t *);
+void swap_free (swap_slot_t, size_t page_cnt);
+void swap_out (swap_slot_t, void *const kpages[], size_t page_cnt);
+void swap_in (swap_slot_t, void *kpage);
+void swap_print_stats (void);
+
+#endif /* vm/swap.h */